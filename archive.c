@@ -0,0 +1,342 @@
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "./nonogram.h"
+#include "./nonogram.inc"
+
+/*
+ * Archives, all numbers little-endian:
+ *
+ *   "NGRA", uint16 version, uint16 reserved
+ *   puzzles           binary hints (see binary.c), then the initial board as
+ *                     a PBM raster of its filled cells and one of its empty
+ *                     cells, then the solution as a PBM raster; each puzzle
+ *                     starts on a multiple of 8 bytes
+ *   index             per puzzle: uint64 offset, uint32 sizes of the hints,
+ *                     board and solution (0 if absent), uint32 reserved
+ *   uint64 index offset, uint32 puzzles count, "NGRA"
+ *
+ * The index comes last, so that archives are written in one go; it is read
+ * where it lies once the archive is mapped.
+ */
+
+#define _ARCHIVE_VERSION 1
+#define _ARCHIVE_HEADER 8
+#define _ARCHIVE_ENTRY 24
+#define _ARCHIVE_TRAILER 16
+
+static const unsigned char _magic[4] = {'N', 'G', 'R', 'A'};
+
+struct _NonoGramArchive {
+  const unsigned char *data;
+  size_t size;
+  const unsigned char *index;
+  int count;
+};
+
+struct _NonoGramArchiveWriter {
+  FILE *file;
+  int in_place;
+  uint64_t offset;
+  unsigned char *index;
+  int count;
+  int capacity;
+  bool failed;
+};
+
+static uint64_t _get(const unsigned char *bytes, int width) {
+  uint64_t value = 0;
+  for (int byte = width - 1; byte >= 0; byte--) {
+    value = value << 8 | bytes[byte];
+  }
+  return value;
+}
+
+static void _put(unsigned char *bytes, int width, uint64_t value) {
+  for (int byte = 0; byte < width; byte++) {
+    bytes[byte] = (unsigned char)(value >> (8 * byte));
+  }
+}
+
+NonoGramArchive *nonogram_archive_open(const char *path) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return NULL;
+  }
+  struct stat status;
+  void *mapped = MAP_FAILED;
+  if (!fstat(fd, &status) &&
+      status.st_size >= _ARCHIVE_HEADER + _ARCHIVE_TRAILER) {
+    mapped = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  close(fd);
+  if (mapped == MAP_FAILED) {
+    return NULL;
+  }
+
+  const unsigned char *data = mapped;
+  size_t size = status.st_size;
+  const unsigned char *trailer = data + size - _ARCHIVE_TRAILER;
+  uint64_t index = _get(trailer, 8);
+  uint64_t count = _get(trailer + 8, 4);
+  NonoGramArchive *archive = NULL;
+  if (!memcmp(data, _magic, sizeof _magic) &&
+      _get(data + 4, 2) == _ARCHIVE_VERSION &&
+      !memcmp(trailer + 12, _magic, sizeof _magic) &&
+      count <= INT32_MAX && index >= _ARCHIVE_HEADER &&
+      // Bounded first, as the sum could wrap
+      index <= size - _ARCHIVE_TRAILER &&
+      count <= (size - _ARCHIVE_TRAILER - index) / _ARCHIVE_ENTRY &&
+      index + count * _ARCHIVE_ENTRY == size - _ARCHIVE_TRAILER) {
+    archive = malloc(sizeof(NonoGramArchive));
+  }
+  if (!archive) {
+    munmap(mapped, size);
+    return NULL;
+  }
+  archive->data = data;
+  archive->size = size;
+  archive->index = data + index;
+  archive->count = (int)count;
+  return archive;
+}
+
+void nonogram_archive_close(NonoGramArchive *archive) {
+  munmap((void *)archive->data, archive->size);
+  free(archive);
+}
+
+int nonogram_archive_get_count(NonoGramArchive *archive) {
+  return archive->count;
+}
+
+/*
+ * Board from PBM rasters of its filled cells and, if empty is not NULL, of
+ * its empty cells; without it, every other cell is empty
+ */
+static NonoGramBoard *_load_board(
+  const unsigned char *filled,
+  const unsigned char *empty,
+  int rows_count,
+  int cols_count
+) {
+  NonoGramBoard *board = nonogram_board_create(rows_count, cols_count);
+  if (!board) {
+    return NULL;
+  }
+  size_t stride = (cols_count + 7) / 8;
+  uint64_t last = cols_count % _NONOGRAM_WORD_BITS ?
+    _NONOGRAM_BIT(cols_count) - 1 : ~(uint64_t)0;
+  bool disjoint = true;
+  for (int row = 0; row < rows_count; row++) {
+    uint64_t *filled_words = board->filled + (size_t)row * board->row_words;
+    uint64_t *empty_words = board->empty + (size_t)row * board->row_words;
+    _nonogram_bitmap_row(filled + row * stride, cols_count, filled_words);
+    if (empty) {
+      _nonogram_bitmap_row(empty + row * stride, cols_count, empty_words);
+    }
+    for (int word = 0; word < board->row_words; word++) {
+      if (empty) {
+        disjoint &= !(filled_words[word] & empty_words[word]);
+      } else {
+        empty_words[word] = ~filled_words[word];
+      }
+    }
+    empty_words[board->row_words - 1] &= last;
+  }
+  if (!disjoint) {
+    nonogram_board_destroy(board);
+    return NULL;
+  }
+  _nonogram_board_sync_columns(board);
+  return board;
+}
+
+int nonogram_archive_get(
+  NonoGramArchive *archive,
+  int index,
+  NonoGramHints **hints,
+  NonoGramBoard **board,
+  NonoGramBoard **solution
+) {
+  NonoGramHints *loaded_hints = NULL;
+  NonoGramBoard *loaded_board = NULL;
+  NonoGramBoard *loaded_solution = NULL;
+  if (index < 0 || index >= archive->count) {
+    return 0;
+  }
+  const unsigned char *entry = archive->index + (size_t)index * _ARCHIVE_ENTRY;
+  uint64_t offset = _get(entry, 8);
+  uint64_t hints_size = _get(entry + 8, 4);
+  uint64_t board_size = _get(entry + 12, 4);
+  uint64_t solution_size = _get(entry + 16, 4);
+  // Puzzles lie between the header and the index
+  uint64_t end = archive->index - archive->data;
+  if (offset < _ARCHIVE_HEADER || offset > end ||
+      hints_size + board_size + solution_size > end - offset) {
+    return 0;
+  }
+  const unsigned char *data = archive->data + offset;
+
+  // The hints give the dimensions, so they are read even if not wanted
+  loaded_hints = _nonogram_hints_load(data, hints_size, true);
+  bool valid = loaded_hints != NULL;
+  if (valid) {
+    int rows_count = loaded_hints->rows_count;
+    int cols_count = loaded_hints->cols_count;
+    uint64_t raster = (uint64_t)rows_count * ((cols_count + 7) / 8);
+    valid = (!board_size || board_size == 2 * raster) &&
+      (!solution_size || solution_size == raster);
+    data += hints_size;
+    if (valid && board_size && board) {
+      loaded_board = _load_board(data, data + raster, rows_count, cols_count);
+      valid = loaded_board != NULL;
+    }
+    data += board_size;
+    if (valid && solution_size && solution) {
+      loaded_solution = _load_board(data, NULL, rows_count, cols_count);
+      valid = loaded_solution != NULL;
+    }
+  }
+  if (!valid || !hints) {
+    if (loaded_hints) {
+      nonogram_hints_destroy(loaded_hints);
+    }
+    loaded_hints = NULL;
+  }
+  if (!valid) {
+    if (loaded_board) {
+      nonogram_board_destroy(loaded_board);
+    }
+    if (loaded_solution) {
+      nonogram_board_destroy(loaded_solution);
+    }
+    return 0;
+  }
+  if (hints) {
+    *hints = loaded_hints;
+  }
+  if (board) {
+    *board = loaded_board;
+  }
+  if (solution) {
+    *solution = loaded_solution;
+  }
+  return 1;
+}
+
+NonoGramArchiveWriter *nonogram_archive_writer_create(
+  FILE *file,
+  int in_place
+) {
+  NonoGramArchiveWriter *writer = calloc(1, sizeof(NonoGramArchiveWriter));
+  if (!writer) {
+    return NULL;
+  }
+  writer->file = file;
+  writer->in_place = in_place;
+  unsigned char header[_ARCHIVE_HEADER] = {0};
+  memcpy(header, _magic, sizeof _magic);
+  _put(header + 4, 2, _ARCHIVE_VERSION);
+  writer->failed = fwrite(header, 1, sizeof header, file) != sizeof header;
+  writer->offset = sizeof header;
+  return writer;
+}
+
+static void _write(NonoGramArchiveWriter *writer, const void *data, size_t size) {
+  if (!writer->failed && size) {
+    writer->failed = fwrite(data, 1, size, writer->file) != size;
+  }
+  writer->offset += size;
+}
+
+/* Write the rows of plane as a PBM raster */
+static void _write_raster(
+  NonoGramArchiveWriter *writer,
+  const NonoGramBoard *board,
+  const uint64_t *plane,
+  unsigned char *row
+) {
+  for (int index = 0; index < board->rows_count; index++) {
+    _nonogram_row_bitmap(
+      plane + (size_t)index * board->row_words, board->cols_count, row
+    );
+    _write(writer, row, (board->cols_count + 7) / 8);
+  }
+}
+
+int nonogram_archive_writer_add(
+  NonoGramArchiveWriter *writer,
+  NonoGramHints *hints,
+  NonoGramBoard *board,
+  NonoGramBoard *solution
+) {
+  int rows_count = hints->rows_count;
+  int cols_count = hints->cols_count;
+  if ((board && (board->rows_count != rows_count ||
+                 board->cols_count != cols_count)) ||
+      (solution && (solution->rows_count != rows_count ||
+                    solution->cols_count != cols_count))) {
+    return 0;
+  }
+  if (writer->count == writer->capacity) {
+    int capacity = writer->capacity ? 2 * writer->capacity : 256;
+    unsigned char *index = realloc(
+      writer->index, (size_t)capacity * _ARCHIVE_ENTRY
+    );
+    if (!index) {
+      return 0;
+    }
+    writer->index = index;
+    writer->capacity = capacity;
+  }
+  size_t hints_size = nonogram_hints_pack(hints, writer->in_place, NULL, 0);
+  size_t stride = (cols_count + 7) / 8;
+  if (hints_size > UINT32_MAX || 2 * rows_count * stride > UINT32_MAX) {
+    return 0;
+  }
+  unsigned char *buffer = malloc(hints_size > stride ? hints_size : stride);
+  if (!buffer) {
+    return 0;
+  }
+
+  unsigned char *entry = writer->index + (size_t)writer->count * _ARCHIVE_ENTRY;
+  memset(entry, 0, _ARCHIVE_ENTRY);
+  _put(entry, 8, writer->offset);
+  _put(entry + 8, 4, hints_size);
+  nonogram_hints_pack(hints, writer->in_place, buffer, hints_size);
+  _write(writer, buffer, hints_size);
+  if (board) {
+    _put(entry + 12, 4, 2 * rows_count * stride);
+    _write_raster(writer, board, board->filled, buffer);
+    _write_raster(writer, board, board->empty, buffer);
+  }
+  if (solution) {
+    _put(entry + 16, 4, rows_count * stride);
+    _write_raster(writer, solution, solution->filled, buffer);
+  }
+  static const unsigned char padding[7] = {0};
+  _write(writer, padding, -writer->offset % 8);
+  free(buffer);
+  writer->count++;
+  return !writer->failed;
+}
+
+int nonogram_archive_writer_close(NonoGramArchiveWriter *writer) {
+  unsigned char trailer[_ARCHIVE_TRAILER];
+  _put(trailer, 8, writer->offset);
+  _put(trailer + 8, 4, writer->count);
+  memcpy(trailer + 12, _magic, sizeof _magic);
+  _write(writer, writer->index, (size_t)writer->count * _ARCHIVE_ENTRY);
+  _write(writer, trailer, sizeof trailer);
+  bool written = !writer->failed && !fflush(writer->file);
+  free(writer->index);
+  free(writer);
+  return written;
+}
@@ -0,0 +1,144 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "./nonogram.h"
+#include "./nonogram.inc"
+
+/*
+ * Arenas hand out memory from a chain of chunks by moving a cursor forward.
+ * Every allocation is preceded by a header holding its size, or 0 when it
+ * comes from malloc, so that _nonogram_free() knows what to do with it. The
+ * most recent allocation is given back at once, which keeps the scratch
+ * buffers of the line solver from piling up; anything else waits for the
+ * next reset. Resetting moves the cursor back to the first chunk and keeps
+ * the chunks, so a worker soon stops asking malloc for anything.
+ */
+
+#define _ARENA_ALIGN _Alignof(max_align_t)
+#define _ARENA_HEADER \
+  ((sizeof(size_t) + _ARENA_ALIGN - 1) / _ARENA_ALIGN * _ARENA_ALIGN)
+#define _ARENA_CHUNK (64 * 1024)
+
+typedef struct _Chunk {
+  struct _Chunk *next;
+  size_t size;
+  max_align_t data[];
+} _Chunk;
+
+struct _NonoGramArena {
+  _Chunk *first;
+  _Chunk *chunk;  // Chunk the cursor is in
+  size_t top;     // Cursor, in bytes from the start of the chunk data
+};
+
+_Thread_local NonoGramArena *_nonogram_arena = NULL;
+
+static _Chunk *_chunk_new(size_t size) {
+  _Chunk *chunk = malloc(sizeof(_Chunk) + size);
+  if (chunk) {
+    chunk->next = NULL;
+    chunk->size = size;
+  }
+  return chunk;
+}
+
+NonoGramArena *nonogram_arena_create(size_t size) {
+  NonoGramArena *arena = malloc(sizeof(NonoGramArena));
+  if (!arena) {
+    return NULL;
+  }
+  arena->first = _chunk_new(size ? size : _ARENA_CHUNK);
+  if (!arena->first) {
+    free(arena);
+    return NULL;
+  }
+  arena->chunk = arena->first;
+  arena->top = 0;
+  return arena;
+}
+
+void nonogram_arena_destroy(NonoGramArena *arena) {
+  if (_nonogram_arena == arena) {
+    _nonogram_arena = NULL;
+  }
+  _Chunk *chunk = arena->first;
+  while (chunk) {
+    _Chunk *next = chunk->next;
+    free(chunk);
+    chunk = next;
+  }
+  free(arena);
+}
+
+void nonogram_arena_reset(NonoGramArena *arena) {
+  arena->chunk = arena->first;
+  arena->top = 0;
+}
+
+size_t nonogram_arena_get_size(NonoGramArena *arena) {
+  size_t size = 0;
+  for (_Chunk *chunk = arena->first; chunk; chunk = chunk->next) {
+    size += chunk->size;
+  }
+  return size;
+}
+
+NonoGramArena *nonogram_arena_use(NonoGramArena *arena) {
+  NonoGramArena *previous = _nonogram_arena;
+  _nonogram_arena = arena;
+  return previous;
+}
+
+void *_nonogram_alloc(size_t size) {
+  if (size > SIZE_MAX / 2) {
+    return NULL;
+  }
+  size_t needed = _ARENA_HEADER +
+    (size + _ARENA_ALIGN - 1) / _ARENA_ALIGN * _ARENA_ALIGN;
+  NonoGramArena *arena = _nonogram_arena;
+  unsigned char *block;
+  if (!arena) {
+    block = malloc(needed);
+    if (!block) {
+      return NULL;
+    }
+    *(size_t *)block = 0;
+    return block + _ARENA_HEADER;
+  }
+
+  // Chunks too small for this block are skipped until the next reset
+  while (arena->top + needed > arena->chunk->size) {
+    if (!arena->chunk->next) {
+      size_t grown = 2 * arena->chunk->size;
+      arena->chunk->next = _chunk_new(grown > needed ? grown : needed);
+      if (!arena->chunk->next) {
+        return NULL;
+      }
+    }
+    arena->chunk = arena->chunk->next;
+    arena->top = 0;
+  }
+  block = (unsigned char *)arena->chunk->data + arena->top;
+  arena->top += needed;
+  *(size_t *)block = needed;
+  return block + _ARENA_HEADER;
+}
+
+void _nonogram_free(void *pointer) {
+  if (!pointer) {
+    return;
+  }
+  unsigned char *block = (unsigned char *)pointer - _ARENA_HEADER;
+  size_t size = *(size_t *)block;
+  if (!size) {
+    free(block);
+    return;
+  }
+  NonoGramArena *arena = _nonogram_arena;
+  if (arena && size <= arena->top &&
+      block == (unsigned char *)arena->chunk->data + arena->top - size) {
+    arena->top -= size;
+  }
+}
@@ -0,0 +1,243 @@
+#include <fcntl.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "./nonogram.h"
+#include "./nonogram.inc"
+
+/*
+ * Binary hints, all numbers little-endian:
+ *
+ *   "NGRM"            magic
+ *   uint16 version    _NONOGRAM_BINARY_VERSION
+ *   uint8 widths      bytes of each offset, then of each clue: 1, 2 or 4
+ *   uint32 rows_count, cols_count, clues_count
+ *   offsets           rows_count + cols_count + 1 of them, as in the hints
+ *   clues             clues_count of them
+ *
+ * With widths of 4 the tables are the int arrays of the hints on
+ * little-endian hosts, and a mapped file is used in place; narrower tables
+ * are widened, which is a copy and no parsing.
+ */
+
+#define _NONOGRAM_BINARY_VERSION 1
+
+static const unsigned char _magic[4] = {'N', 'G', 'R', 'M'};
+
+static uint32_t _get(const unsigned char *data, int width, size_t index) {
+  const unsigned char *bytes = data + index * width;
+  switch (width) {
+    case 1:
+      return bytes[0];
+    case 2:
+      return bytes[0] | (uint32_t)bytes[1] << 8;
+    default:
+      return bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16 |
+        (uint32_t)bytes[3] << 24;
+  }
+}
+
+static void _put(unsigned char *data, int width, size_t index, uint32_t value) {
+  unsigned char *bytes = data + index * width;
+  for (int byte = 0; byte < width; byte++) {
+    bytes[byte] = (unsigned char)(value >> (8 * byte));
+  }
+}
+
+static int _width(uint32_t max) {
+  return max <= UINT8_MAX ? 1 : max <= UINT16_MAX ? 2 : 4;
+}
+
+size_t nonogram_hints_pack(
+  NonoGramHints *hints,
+  int in_place,
+  void *buffer,
+  size_t size
+) {
+  int lines_count = hints->rows_count + hints->cols_count;
+  int clues_count = hints->offsets[lines_count];
+  int offset_width = 4;
+  int clue_width = 4;
+  if (!in_place) {
+    uint32_t max = 0;
+    for (int clue = 0; clue < clues_count; clue++) {
+      if ((uint32_t)hints->clues[clue] > max) {
+        max = hints->clues[clue];
+      }
+    }
+    offset_width = _width(clues_count);
+    clue_width = _width(max);
+  }
+  size_t needed = _NONOGRAM_BINARY_HEADER +
+    ((size_t)lines_count + 1) * offset_width +
+    (size_t)clues_count * clue_width;
+  if (size < needed) {
+    return needed;
+  }
+
+  unsigned char *data = buffer;
+  memcpy(data, _magic, sizeof _magic);
+  _put(data + 4, 2, 0, _NONOGRAM_BINARY_VERSION);
+  data[6] = (unsigned char)offset_width;
+  data[7] = (unsigned char)clue_width;
+  _put(data + 8, 4, 0, hints->rows_count);
+  _put(data + 8, 4, 1, hints->cols_count);
+  _put(data + 8, 4, 2, clues_count);
+  data += _NONOGRAM_BINARY_HEADER;
+  for (int line = 0; line <= lines_count; line++) {
+    _put(data, offset_width, line, hints->offsets[line]);
+  }
+  data += ((size_t)lines_count + 1) * offset_width;
+  for (int clue = 0; clue < clues_count; clue++) {
+    _put(data, clue_width, clue, hints->clues[clue]);
+  }
+  return needed;
+}
+
+/* Read count numbers of width bytes into ints */
+static void _widen(const unsigned char *data, int width, size_t count, int *out) {
+  switch (width) {
+    case 1:
+      for (size_t index = 0; index < count; index++) {
+        out[index] = data[index];
+      }
+      break;
+    case 2:
+      for (size_t index = 0; index < count; index++) {
+        out[index] = data[2 * index] | data[2 * index + 1] << 8;
+      }
+      break;
+    default:
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+      memcpy(out, data, count * sizeof(int));
+#else
+      for (size_t index = 0; index < count; index++) {
+        out[index] = (int)_get(data, 4, index);
+      }
+#endif
+      break;
+  }
+}
+
+/*
+ * Offsets run from 0 to the number of clues, clues are positive and fit in
+ * their line
+ */
+static bool _valid(const NonoGramHints *hints, int clues_count) {
+  int rows_count = hints->rows_count;
+  int lines_count = rows_count + hints->cols_count;
+  if (hints->offsets[0] || hints->offsets[lines_count] != clues_count) {
+    return false;
+  }
+  bool valid = true;
+  for (int line = 0; line < lines_count; line++) {
+    valid &= hints->offsets[line] <= hints->offsets[line + 1];
+  }
+  for (int clue = 0; clue < clues_count; clue++) {
+    valid &= hints->clues[clue] > 0;
+  }
+  for (int line = 0; line < lines_count && valid; line++) {
+    valid = _nonogram_line_fits(
+      _NONOGRAM_LINE_CLUES(hints, line),
+      _NONOGRAM_LINE_CLUES_COUNT(hints, line),
+      line < rows_count ? hints->cols_count : rows_count
+    );
+  }
+  return valid;
+}
+
+NonoGramHints *_nonogram_hints_load(
+  const void *buffer,
+  size_t size,
+  bool in_place
+) {
+  const unsigned char *data = buffer;
+  if (size < _NONOGRAM_BINARY_HEADER ||
+      memcmp(data, _magic, sizeof _magic) ||
+      _get(data + 4, 2, 0) != _NONOGRAM_BINARY_VERSION) {
+    return NULL;
+  }
+  int offset_width = data[6];
+  int clue_width = data[7];
+  uint32_t rows_count = _get(data + 8, 4, 0);
+  uint32_t cols_count = _get(data + 8, 4, 1);
+  uint32_t clues_count = _get(data + 8, 4, 2);
+  if ((offset_width != 1 && offset_width != 2 && offset_width != 4) ||
+      (clue_width != 1 && clue_width != 2 && clue_width != 4) ||
+      !rows_count || !cols_count ||
+      rows_count > INT_MAX / 2 || cols_count > INT_MAX / 2 ||
+      clues_count > INT_MAX) {
+    return NULL;
+  }
+  size_t lines_count = rows_count + cols_count;
+  if (size - _NONOGRAM_BINARY_HEADER < (lines_count + 1) * offset_width +
+      (size_t)clues_count * clue_width) {
+    return NULL;
+  }
+  const unsigned char *offsets = data + _NONOGRAM_BINARY_HEADER;
+  const unsigned char *clues = offsets + (lines_count + 1) * offset_width;
+
+  NonoGramHints *hints;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  if (in_place && offset_width == sizeof(int) && clue_width == sizeof(int) &&
+      (uintptr_t)offsets % _Alignof(int) == 0) {
+    hints = _nonogram_alloc(sizeof(NonoGramHints));
+    if (hints) {
+      hints->rows_count = rows_count;
+      hints->cols_count = cols_count;
+      hints->offsets = (int *)offsets;
+      hints->clues = (int *)clues;
+      hints->mapped = NULL;
+      hints->mapped_size = 0;
+    }
+  } else
+#endif
+  {
+    hints = _nonogram_hints_new(rows_count, cols_count, clues_count);
+    if (hints) {
+      _widen(offsets, offset_width, lines_count + 1, hints->offsets);
+      _widen(clues, clue_width, clues_count, hints->clues);
+    }
+  }
+  if (hints && !_valid(hints, clues_count)) {
+    nonogram_hints_destroy(hints);
+    return NULL;
+  }
+  return hints;
+}
+
+NonoGramHints *nonogram_hints_unpack(const void *buffer, size_t size) {
+  return _nonogram_hints_load(buffer, size, false);
+}
+
+NonoGramHints *nonogram_hints_map(const char *path) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return NULL;
+  }
+  struct stat status;
+  void *mapped = MAP_FAILED;
+  if (!fstat(fd, &status) && status.st_size >= _NONOGRAM_BINARY_HEADER) {
+    mapped = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  close(fd);
+  if (mapped == MAP_FAILED) {
+    return NULL;
+  }
+  NonoGramHints *hints = _nonogram_hints_load(mapped, status.st_size, true);
+  if (hints && hints->offsets == (int *)(hints + 1)) {
+    // Widened into the hints: the file is no longer needed
+    munmap(mapped, status.st_size);
+  } else if (hints) {
+    hints->mapped = mapped;
+    hints->mapped_size = status.st_size;
+  } else {
+    munmap(mapped, status.st_size);
+  }
+  return hints;
+}
@@ -0,0 +1,350 @@
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define _NONOGRAM_X86
+#endif
+
+#include "./nonogram.h"
+#include "./nonogram.inc"
+
+/*
+ * Per-cell stages, packing int cells into words and unpacking PBM bytes, run
+ * 16 or 32 cells at a time with SSE2 or AVX2 when the processor has them;
+ * the level is read from the processor the first time it is needed. Runs are
+ * found on whole words: a run starts where a filled cell follows an empty one
+ * (x & ~(x << 1)) and ends where an empty one follows (x & ~(x >> 1)).
+ * Columns go through a 64x64 block transpose so that they are read as rows.
+ */
+
+static atomic_int _simd_level = -1;
+
+static int _simd_supported(void) {
+#ifdef _NONOGRAM_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return _NONOGRAM_SIMD_AVX2;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    return _NONOGRAM_SIMD_SSE2;
+  }
+#endif
+  return _NONOGRAM_SIMD_SCALAR;
+}
+
+static int _simd(void) {
+  int level = atomic_load_explicit(&_simd_level, memory_order_relaxed);
+  if (level < 0) {
+    level = _simd_supported();
+    atomic_store_explicit(&_simd_level, level, memory_order_relaxed);
+  }
+  return level;
+}
+
+int _nonogram_simd_select(int level) {
+  int supported = _simd_supported();
+  int previous = _simd();
+  atomic_store_explicit(
+    &_simd_level,
+    level < supported ? level : supported,
+    memory_order_relaxed
+  );
+  return previous;
+}
+
+/* Reverse the bit order inside each byte of x */
+static uint64_t _reverse_bits_in_bytes(uint64_t x) {
+  x = ((x >> 1) & 0x5555555555555555) | ((x & 0x5555555555555555) << 1);
+  x = ((x >> 2) & 0x3333333333333333) | ((x & 0x3333333333333333) << 2);
+  x = ((x >> 4) & 0x0f0f0f0f0f0f0f0f) | ((x & 0x0f0f0f0f0f0f0f0f) << 4);
+  return x;
+}
+
+/* Unpack whole bytes of a PBM row; returns the number of bytes done */
+static int _bitmap_bytes_scalar(
+  const unsigned char *bytes,
+  int count,
+  unsigned char *out
+) {
+  int byte = 0;
+  for (; byte + 8 <= count; byte += 8) {
+    uint64_t bits;
+    memcpy(&bits, bytes + byte, sizeof bits);
+    bits = _reverse_bits_in_bytes(bits);
+    memcpy(out + byte, &bits, sizeof bits);
+  }
+  return byte;
+}
+
+#ifdef _NONOGRAM_X86
+__attribute__((target("sse2")))
+static int _bitmap_bytes_sse2(
+  const unsigned char *bytes,
+  int count,
+  unsigned char *out
+) {
+  const __m128i m1 = _mm_set1_epi8(0x55);
+  const __m128i m2 = _mm_set1_epi8(0x33);
+  const __m128i m4 = _mm_set1_epi8(0x0f);
+  int byte = 0;
+  for (; byte + 16 <= count; byte += 16) {
+    __m128i x = _mm_loadu_si128((const __m128i *)(bytes + byte));
+    x = _mm_or_si128(_mm_and_si128(_mm_srli_epi64(x, 1), m1),
+                     _mm_slli_epi64(_mm_and_si128(x, m1), 1));
+    x = _mm_or_si128(_mm_and_si128(_mm_srli_epi64(x, 2), m2),
+                     _mm_slli_epi64(_mm_and_si128(x, m2), 2));
+    x = _mm_or_si128(_mm_and_si128(_mm_srli_epi64(x, 4), m4),
+                     _mm_slli_epi64(_mm_and_si128(x, m4), 4));
+    _mm_storeu_si128((__m128i *)(out + byte), x);
+  }
+  return byte;
+}
+
+__attribute__((target("avx2")))
+static int _bitmap_bytes_avx2(
+  const unsigned char *bytes,
+  int count,
+  unsigned char *out
+) {
+  // Reversed nibbles, looked up for the low and high nibble of each byte
+  const __m256i reversed = _mm256_setr_epi8(
+    0x0, 0x8, 0x4, 0xc, 0x2, 0xa, 0x6, 0xe,
+    0x1, 0x9, 0x5, 0xd, 0x3, 0xb, 0x7, 0xf,
+    0x0, 0x8, 0x4, 0xc, 0x2, 0xa, 0x6, 0xe,
+    0x1, 0x9, 0x5, 0xd, 0x3, 0xb, 0x7, 0xf
+  );
+  const __m256i low = _mm256_set1_epi8(0x0f);
+  int byte = 0;
+  for (; byte + 32 <= count; byte += 32) {
+    __m256i x = _mm256_loadu_si256((const __m256i *)(bytes + byte));
+    __m256i lo = _mm256_shuffle_epi8(reversed, _mm256_and_si256(x, low));
+    __m256i hi = _mm256_shuffle_epi8(
+      reversed, _mm256_and_si256(_mm256_srli_epi16(x, 4), low)
+    );
+    _mm256_storeu_si256(
+      (__m256i *)(out + byte),
+      _mm256_or_si256(_mm256_slli_epi16(lo, 4), hi)
+    );
+  }
+  return byte;
+}
+#endif
+
+void _nonogram_bitmap_row(
+  const unsigned char *bytes,
+  int cols_count,
+  uint64_t *words
+) {
+  // Byte i of a word holds columns 8i to 8i+7, first column in the most
+  // significant bit as in PBM files: once the bits of each byte are
+  // reversed, the bytes are the words in little-endian order
+  int stride = (cols_count + 7) / 8;
+  int words_count = _NONOGRAM_WORDS(cols_count);
+  unsigned char *out = (unsigned char *)words;
+  int done = 0;
+#ifdef _NONOGRAM_X86
+  switch (_simd()) {
+    case _NONOGRAM_SIMD_AVX2:
+      done = _bitmap_bytes_avx2(bytes, stride, out);
+      break;
+    case _NONOGRAM_SIMD_SSE2:
+      done = _bitmap_bytes_sse2(bytes, stride, out);
+      break;
+  }
+#endif
+  done += _bitmap_bytes_scalar(bytes + done, stride - done, out + done);
+  for (int word = done / 8; word < words_count; word++) {
+    uint64_t bits = 0;
+    int first = word * 8;
+    int last = first + 8 < stride ? first + 8 : stride;
+    for (int byte = first; byte < last; byte++) {
+      bits |= (uint64_t)bytes[byte] << (8 * (byte - first));
+    }
+    words[word] = _reverse_bits_in_bytes(bits);
+  }
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  for (int word = 0; word < done / 8; word++) {
+    words[word] = __builtin_bswap64(words[word]);
+  }
+#endif
+  if (cols_count % _NONOGRAM_WORD_BITS) {
+    words[words_count - 1] &= _NONOGRAM_BIT(cols_count) - 1;
+  }
+}
+
+void _nonogram_row_bitmap(
+  const uint64_t *words,
+  int cols_count,
+  unsigned char *bytes
+) {
+  int stride = (cols_count + 7) / 8;
+  for (int byte = 0; byte < stride; byte++) {
+    uint64_t bits = _reverse_bits_in_bytes(words[byte / 8]);
+    bytes[byte] = (unsigned char)(bits >> (8 * (byte % 8)));
+  }
+}
+
+/* Pack whole words of cells; returns the number of words done */
+static int _pack_words_scalar(const int *cells, int words_count, uint64_t *words) {
+  for (int word = 0; word < words_count; word++) {
+    uint64_t bits = 0;
+    for (int cell = 0; cell < _NONOGRAM_WORD_BITS; cell++) {
+      bits |= (uint64_t)(cells[cell] == NONOGRAM_FILLED) << cell;
+    }
+    words[word] = bits;
+    cells += _NONOGRAM_WORD_BITS;
+  }
+  return words_count;
+}
+
+#ifdef _NONOGRAM_X86
+__attribute__((target("sse2")))
+static int _pack_words_sse2(const int *cells, int words_count, uint64_t *words) {
+  const __m128i filled = _mm_set1_epi32(NONOGRAM_FILLED);
+  for (int word = 0; word < words_count; word++) {
+    uint64_t bits = 0;
+    for (int cell = 0; cell < _NONOGRAM_WORD_BITS; cell += 4) {
+      __m128i x = _mm_loadu_si128((const __m128i *)(cells + cell));
+      uint64_t mask = _mm_movemask_ps(
+        _mm_castsi128_ps(_mm_cmpeq_epi32(x, filled))
+      );
+      bits |= mask << cell;
+    }
+    words[word] = bits;
+    cells += _NONOGRAM_WORD_BITS;
+  }
+  return words_count;
+}
+
+__attribute__((target("avx2")))
+static int _pack_words_avx2(const int *cells, int words_count, uint64_t *words) {
+  const __m256i filled = _mm256_set1_epi32(NONOGRAM_FILLED);
+  for (int word = 0; word < words_count; word++) {
+    uint64_t bits = 0;
+    for (int cell = 0; cell < _NONOGRAM_WORD_BITS; cell += 8) {
+      __m256i x = _mm256_loadu_si256((const __m256i *)(cells + cell));
+      uint64_t mask = _mm256_movemask_ps(
+        _mm256_castsi256_ps(_mm256_cmpeq_epi32(x, filled))
+      );
+      bits |= mask << cell;
+    }
+    words[word] = bits;
+    cells += _NONOGRAM_WORD_BITS;
+  }
+  return words_count;
+}
+#endif
+
+void _nonogram_pack_line(const int *cells, int length, uint64_t *words) {
+  int whole = length / _NONOGRAM_WORD_BITS;
+  int done;
+  switch (_simd()) {
+#ifdef _NONOGRAM_X86
+    case _NONOGRAM_SIMD_AVX2:
+      done = _pack_words_avx2(cells, whole, words);
+      break;
+    case _NONOGRAM_SIMD_SSE2:
+      done = _pack_words_sse2(cells, whole, words);
+      break;
+#endif
+    default:
+      done = _pack_words_scalar(cells, whole, words);
+      break;
+  }
+  if (done < _NONOGRAM_WORDS(length)) {
+    uint64_t bits = 0;
+    for (int cell = done * _NONOGRAM_WORD_BITS; cell < length; cell++) {
+      bits |= (uint64_t)(cells[cell] == NONOGRAM_FILLED) <<
+        (cell % _NONOGRAM_WORD_BITS);
+    }
+    words[done] = bits;
+  }
+}
+
+/*
+ * Transpose a 64x64 bit block in place, row i being block[i] with column j
+ * in bit j: each step swaps the off-diagonal quarters of the sub-blocks, from
+ * 32x32 down to 1x1.
+ */
+static void _transpose_block(uint64_t *block) {
+  uint64_t mask = 0x00000000ffffffff;
+  for (int width = 32; width; width >>= 1, mask ^= mask << width) {
+    for (int row = 0; row < 64; row = ((row | width) + 1) & ~width) {
+      uint64_t swapped = ((block[row] >> width) ^ block[row | width]) & mask;
+      block[row] ^= swapped << width;
+      block[row | width] ^= swapped;
+    }
+  }
+}
+
+void _nonogram_transpose(
+  const uint64_t *source,
+  int rows_count,
+  int cols_count,
+  int source_words,
+  uint64_t *target,
+  int target_words
+) {
+  uint64_t block[64];
+  for (int first = 0; first < rows_count; first += 64) {
+    int rows = rows_count - first < 64 ? rows_count - first : 64;
+    for (int word = 0; word < source_words; word++) {
+      for (int row = 0; row < rows; row++) {
+        block[row] = source[(size_t)(first + row) * source_words + word];
+      }
+      for (int row = rows; row < 64; row++) {
+        block[row] = 0;
+      }
+      _transpose_block(block);
+      int cols = cols_count - 64 * word < 64 ? cols_count - 64 * word : 64;
+      for (int col = 0; col < cols; col++) {
+        target[(size_t)(64 * word + col) * target_words + first / 64] =
+          block[col];
+      }
+    }
+  }
+}
+
+int _nonogram_board_runs(const uint64_t *words, int length, int *runs) {
+  int words_count = _NONOGRAM_WORDS(length);
+  int count = 0;
+  int start = 0;
+  uint64_t carry = 0;
+  for (int word = 0; word < words_count; word++) {
+    uint64_t bits = words[word];
+    uint64_t next = word + 1 < words_count ? words[word + 1] & 1 : 0;
+    uint64_t starts = bits & ~((bits << 1) | carry);
+    uint64_t ends = bits & ~((bits >> 1) | (next << (_NONOGRAM_WORD_BITS - 1)));
+    int base = word * _NONOGRAM_WORD_BITS;
+    carry = bits >> (_NONOGRAM_WORD_BITS - 1);
+    // Each end closes the run of the last start at or before it
+    while (ends) {
+      int end = __builtin_ctzll(ends);
+      if (starts && __builtin_ctzll(starts) <= end) {
+        start = base + __builtin_ctzll(starts);
+        starts &= starts - 1;
+      }
+      runs[count++] = base + end + 1 - start;
+      ends &= ends - 1;
+    }
+    // A run going on into the next word
+    if (starts) {
+      start = base + __builtin_ctzll(starts);
+    }
+  }
+  return count;
+}
+
+int _nonogram_board_runs_count(const uint64_t *words, int length) {
+  int count = 0;
+  uint64_t carry = 0;
+  for (int word = 0; word < _NONOGRAM_WORDS(length); word++) {
+    uint64_t bits = words[word];
+    count += __builtin_popcountll(bits & ~((bits << 1) | carry));
+    carry = bits >> (_NONOGRAM_WORD_BITS - 1);
+  }
+  return count;
+}
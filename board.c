@@ -0,0 +1,247 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "./nonogram.h"
+#include "./nonogram.inc"
+
+NonoGramBoard *nonogram_board_create(int rows_count, int cols_count) {
+  if (rows_count <= 0 || cols_count <= 0) {
+    return NULL;
+  }
+  int row_words = _NONOGRAM_WORDS(cols_count);
+  int col_words = _NONOGRAM_WORDS(rows_count);
+  size_t row_plane = (size_t)rows_count * row_words;
+  size_t col_plane = (size_t)cols_count * col_words;
+  size_t header = (sizeof(NonoGramBoard) + sizeof(uint64_t) - 1) /
+                  sizeof(uint64_t) * sizeof(uint64_t);
+  size_t size = header + 2 * (row_plane + col_plane) * sizeof(uint64_t);
+  NonoGramBoard *board = _nonogram_alloc(size);
+  if (!board) {
+    return NULL;
+  }
+  memset(board, 0, size);
+  board->rows_count = rows_count;
+  board->cols_count = cols_count;
+  board->row_words = row_words;
+  board->col_words = col_words;
+  board->filled = (uint64_t *)((char *)board + header);
+  board->empty = board->filled + row_plane;
+  board->filled_t = board->empty + row_plane;
+  board->empty_t = board->filled_t + col_plane;
+  return board;
+}
+
+NonoGramBoard *nonogram_board_copy(const NonoGramBoard *board) {
+  NonoGramBoard *copy = nonogram_board_create(
+    board->rows_count,
+    board->cols_count
+  );
+  if (copy) {
+    size_t words = 2 * ((size_t)board->rows_count * board->row_words +
+                        (size_t)board->cols_count * board->col_words);
+    memcpy(copy->filled, board->filled, words * sizeof(uint64_t));
+  }
+  return copy;
+}
+
+NonoGramBoard *nonogram_board_create_from_array(
+  int **cells,
+  int rows_count,
+  int cols_count
+) {
+  NonoGramBoard *board = nonogram_board_create(rows_count, cols_count);
+  if (board) {
+    for (int row = 0; row < rows_count; row++) {
+      for (int col = 0; col < cols_count; col++) {
+        nonogram_board_set(board, row, col, cells[row][col]);
+      }
+    }
+  }
+  return board;
+}
+
+NonoGramBoard *nonogram_board_create_from_bitmap(
+  const unsigned char *bitmap,
+  int rows_count,
+  int cols_count
+) {
+  NonoGramBoard *board = nonogram_board_create(rows_count, cols_count);
+  if (!board) {
+    return NULL;
+  }
+  int stride = (cols_count + 7) / 8;
+  for (int row = 0; row < rows_count; row++) {
+    _nonogram_bitmap_row(
+      bitmap + (size_t)row * stride,
+      cols_count,
+      board->filled + (size_t)row * board->row_words
+    );
+  }
+  _nonogram_board_sync_columns(board);
+  return board;
+}
+
+void nonogram_board_destroy(NonoGramBoard *board) {
+  _nonogram_free(board);
+}
+
+int nonogram_board_get_rows_count(NonoGramBoard *board) {
+  return board->rows_count;
+}
+
+int nonogram_board_get_cols_count(NonoGramBoard *board) {
+  return board->cols_count;
+}
+
+int nonogram_board_get(NonoGramBoard *board, int row, int col) {
+  assert(row < board->rows_count);
+  assert(col < board->cols_count);
+  size_t word = (size_t)row * board->row_words + col / _NONOGRAM_WORD_BITS;
+  uint64_t bit = _NONOGRAM_BIT(col);
+  if (board->filled[word] & bit) {
+    return NONOGRAM_FILLED;
+  }
+  if (board->empty[word] & bit) {
+    return NONOGRAM_EMPTY;
+  }
+  return NONOGRAM_UNKNOWN;
+}
+
+void nonogram_board_set(NonoGramBoard *board, int row, int col, int value) {
+  assert(row < board->rows_count);
+  assert(col < board->cols_count);
+  size_t word = (size_t)row * board->row_words + col / _NONOGRAM_WORD_BITS;
+  size_t word_t = (size_t)col * board->col_words + row / _NONOGRAM_WORD_BITS;
+  uint64_t bit = _NONOGRAM_BIT(col);
+  uint64_t bit_t = _NONOGRAM_BIT(row);
+  board->filled[word] &= ~bit;
+  board->empty[word] &= ~bit;
+  board->filled_t[word_t] &= ~bit_t;
+  board->empty_t[word_t] &= ~bit_t;
+  if (value == NONOGRAM_FILLED) {
+    board->filled[word] |= bit;
+    board->filled_t[word_t] |= bit_t;
+  } else if (value == NONOGRAM_EMPTY) {
+    board->empty[word] |= bit;
+    board->empty_t[word_t] |= bit_t;
+  }
+}
+
+int nonogram_board_get_unknown_count(NonoGramBoard *board) {
+  size_t words = (size_t)board->rows_count * board->row_words;
+  int known = 0;
+  for (size_t word = 0; word < words; word++) {
+    known += __builtin_popcountll(board->filled[word] | board->empty[word]);
+  }
+  return board->rows_count * board->cols_count - known;
+}
+
+void _nonogram_board_sync_columns(NonoGramBoard *board) {
+  _nonogram_transpose(board->filled, board->rows_count, board->cols_count,
+                      board->row_words, board->filled_t, board->col_words);
+  _nonogram_transpose(board->empty, board->rows_count, board->cols_count,
+                      board->row_words, board->empty_t, board->col_words);
+}
+
+void _nonogram_board_get_line(
+  const NonoGramBoard *board,
+  int line,
+  int *cells
+) {
+  const uint64_t *filled = _NONOGRAM_BOARD_FILLED(board, line);
+  const uint64_t *empty = _NONOGRAM_BOARD_EMPTY(board, line);
+  int length = _NONOGRAM_BOARD_LENGTH(board, line);
+  for (int cell = 0; cell < length; cell++) {
+    int word = cell / _NONOGRAM_WORD_BITS;
+    uint64_t bit = _NONOGRAM_BIT(cell);
+    if (filled[word] & bit) {
+      cells[cell] = NONOGRAM_FILLED;
+    } else if (empty[word] & bit) {
+      cells[cell] = NONOGRAM_EMPTY;
+    } else {
+      cells[cell] = NONOGRAM_UNKNOWN;
+    }
+  }
+}
+
+void _nonogram_board_store_line(
+  NonoGramBoard *board,
+  NonoGramBoard *changes,
+  int line,
+  const int *cells
+) {
+  uint64_t *filled = _NONOGRAM_BOARD_FILLED(board, line);
+  uint64_t *empty = _NONOGRAM_BOARD_EMPTY(board, line);
+  uint64_t *changed_filled = _NONOGRAM_BOARD_FILLED(changes, line);
+  uint64_t *changed_empty = _NONOGRAM_BOARD_EMPTY(changes, line);
+  int length = _NONOGRAM_BOARD_LENGTH(board, line);
+  for (int word = 0; word < _NONOGRAM_WORDS(length); word++) {
+    uint64_t new_filled = 0;
+    uint64_t new_empty = 0;
+    int first = word * _NONOGRAM_WORD_BITS;
+    int last = first + _NONOGRAM_WORD_BITS < length
+      ? first + _NONOGRAM_WORD_BITS
+      : length;
+    for (int cell = first; cell < last; cell++) {
+      if (cells[cell] == NONOGRAM_FILLED) {
+        new_filled |= _NONOGRAM_BIT(cell);
+      } else if (cells[cell] == NONOGRAM_EMPTY) {
+        new_empty |= _NONOGRAM_BIT(cell);
+      }
+    }
+    changed_filled[word] = new_filled & ~filled[word];
+    changed_empty[word] = new_empty & ~empty[word];
+    filled[word] |= new_filled;
+    empty[word] |= new_empty;
+  }
+}
+
+/* Set bit of the crossing lines for every cell set in changes */
+static void _flush_bits(
+  uint64_t *changed,
+  int words,
+  uint64_t *cross,
+  int cross_words,
+  int index,
+  int cross_first,
+  unsigned char *dirty
+) {
+  for (int word = 0; word < words; word++) {
+    uint64_t bits = changed[word];
+    changed[word] = 0;
+    while (bits) {
+      int cell = word * _NONOGRAM_WORD_BITS + __builtin_ctzll(bits);
+      cross[(size_t)cell * cross_words + index / _NONOGRAM_WORD_BITS] |=
+        _NONOGRAM_BIT(index);
+      if (dirty) {
+        dirty[cross_first + cell] = 1;
+      }
+      bits &= bits - 1;
+    }
+  }
+}
+
+void _nonogram_board_flush_line(
+  NonoGramBoard *board,
+  NonoGramBoard *changes,
+  int line,
+  unsigned char *dirty
+) {
+  int words = _NONOGRAM_BOARD_LINE_WORDS(board, line);
+  uint64_t *changed_filled = _NONOGRAM_BOARD_FILLED(changes, line);
+  uint64_t *changed_empty = _NONOGRAM_BOARD_EMPTY(changes, line);
+  if (_NONOGRAM_BOARD_IS_COL(board, line)) {
+    int col = line - board->rows_count;
+    _flush_bits(changed_filled, words, board->filled, board->row_words,
+                col, 0, dirty);
+    _flush_bits(changed_empty, words, board->empty, board->row_words,
+                col, 0, dirty);
+  } else {
+    _flush_bits(changed_filled, words, board->filled_t, board->col_words,
+                line, board->rows_count, dirty);
+    _flush_bits(changed_empty, words, board->empty_t, board->col_words,
+                line, board->rows_count, dirty);
+  }
+}
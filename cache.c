@@ -0,0 +1,348 @@
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "./nonogram.h"
+#include "./nonogram.inc"
+
+/*
+ * Solution caches are directories holding one archive per puzzle (see
+ * archive.c), named after the hash of its hints. A puzzle is stored in
+ * canonical form: the least of the 8 images of its hints under the
+ * symmetries of the board, with the solution turned alike, so that rotated
+ * and mirrored puzzles find it too. The canonical hints are stored along
+ * the solution and compared on lookup, which makes hash collisions
+ * harmless. Entries are written to a temporary file, then renamed, so that
+ * any number of threads and processes can share a cache.
+ *
+ * A symmetry mirrors the columns, then the rows, then transposes the board,
+ * as its bits tell.
+ */
+
+#define _MIRROR_COLS 1
+#define _MIRROR_ROWS 2
+#define _TRANSPOSE 4
+#define _SYMMETRIES 8
+
+struct _NonoGramCache {
+  char *path;
+};
+
+/*
+ * Line of hints giving line of their image under symmetry, and whether its
+ * clues come in reverse order
+ */
+static int _source_line(
+  NonoGramHints *hints,
+  int symmetry,
+  int line,
+  bool *reversed
+) {
+  int rows_count = hints->rows_count;
+  int cols_count = hints->cols_count;
+  int image_rows_count = symmetry & _TRANSPOSE ? cols_count : rows_count;
+  bool is_col = line >= image_rows_count;
+  int index = is_col ? line - image_rows_count : line;
+  if (symmetry & _TRANSPOSE) {
+    is_col = !is_col;
+  }
+  if (is_col) {
+    *reversed = symmetry & _MIRROR_ROWS;
+    return rows_count +
+      (symmetry & _MIRROR_COLS ? cols_count - 1 - index : index);
+  }
+  *reversed = symmetry & _MIRROR_COLS;
+  return symmetry & _MIRROR_ROWS ? rows_count - 1 - index : index;
+}
+
+static int _clue(NonoGramHints *hints, int line, bool reversed, int index) {
+  int count = _NONOGRAM_LINE_CLUES_COUNT(hints, line);
+  return _NONOGRAM_LINE_CLUES(hints, line)[reversed ? count - 1 - index : index];
+}
+
+/*
+ * Order of the images of hints under two symmetries: by dimensions, then by
+ * clue counts line after line, then by clues, as the tables of the hints
+ * would compare
+ */
+static int _compare(NonoGramHints *hints, int first, int second) {
+  int first_rows = first & _TRANSPOSE ? hints->cols_count : hints->rows_count;
+  int second_rows =
+    second & _TRANSPOSE ? hints->cols_count : hints->rows_count;
+  if (first_rows != second_rows) {
+    return first_rows < second_rows ? -1 : 1;
+  }
+  int lines_count = hints->rows_count + hints->cols_count;
+  for (int line = 0; line < lines_count; line++) {
+    bool reversed;
+    int first_count = _NONOGRAM_LINE_CLUES_COUNT(
+      hints, _source_line(hints, first, line, &reversed)
+    );
+    int second_count = _NONOGRAM_LINE_CLUES_COUNT(
+      hints, _source_line(hints, second, line, &reversed)
+    );
+    if (first_count != second_count) {
+      return first_count < second_count ? -1 : 1;
+    }
+  }
+  for (int line = 0; line < lines_count; line++) {
+    bool first_reversed, second_reversed;
+    int first_line = _source_line(hints, first, line, &first_reversed);
+    int second_line = _source_line(hints, second, line, &second_reversed);
+    int count = _NONOGRAM_LINE_CLUES_COUNT(hints, first_line);
+    for (int index = 0; index < count; index++) {
+      int first_clue = _clue(hints, first_line, first_reversed, index);
+      int second_clue = _clue(hints, second_line, second_reversed, index);
+      if (first_clue != second_clue) {
+        return first_clue < second_clue ? -1 : 1;
+      }
+    }
+  }
+  return 0;
+}
+
+/* Canonical image of hints, and in symmetry the symmetry giving it */
+static NonoGramHints *_canonical(NonoGramHints *hints, int *symmetry) {
+  int best = 0;
+  for (int other = 1; other < _SYMMETRIES; other++) {
+    if (_compare(hints, other, best) < 0) {
+      best = other;
+    }
+  }
+  int lines_count = hints->rows_count + hints->cols_count;
+  NonoGramHints *image = _nonogram_hints_new(
+    best & _TRANSPOSE ? hints->cols_count : hints->rows_count,
+    best & _TRANSPOSE ? hints->rows_count : hints->cols_count,
+    hints->offsets[lines_count]
+  );
+  if (!image) {
+    return NULL;
+  }
+  image->offsets[0] = 0;
+  for (int line = 0; line < lines_count; line++) {
+    bool reversed;
+    int source = _source_line(hints, best, line, &reversed);
+    int count = _NONOGRAM_LINE_CLUES_COUNT(hints, source);
+    for (int index = 0; index < count; index++) {
+      image->clues[image->offsets[line] + index] =
+        _clue(hints, source, reversed, index);
+    }
+    image->offsets[line + 1] = image->offsets[line] + count;
+  }
+  *symmetry = best;
+  return image;
+}
+
+/* FNV-1a over the dimensions and tables of hints, as 32-bit numbers */
+static uint64_t _hash(NonoGramHints *hints) {
+  int lines_count = hints->rows_count + hints->cols_count;
+  uint64_t hash = 14695981039346656037ULL;
+  int header[2] = {hints->rows_count, hints->cols_count};
+  const int *tables[3] = {header, hints->offsets, hints->clues};
+  int counts[3] = {2, lines_count + 1, hints->offsets[lines_count]};
+  for (int table = 0; table < 3; table++) {
+    for (int index = 0; index < counts[table]; index++) {
+      uint32_t value = (uint32_t)tables[table][index];
+      for (int byte = 0; byte < 4; byte++) {
+        hash ^= (value >> (8 * byte)) & 0xff;
+        hash *= 1099511628211ULL;
+      }
+    }
+  }
+  return hash;
+}
+
+uint64_t nonogram_hints_hash(NonoGramHints *hints) {
+  int symmetry;
+  NonoGramHints *canonical = _canonical(hints, &symmetry);
+  if (!canonical) {
+    return 0;
+  }
+  uint64_t hash = _hash(canonical);
+  nonogram_hints_destroy(canonical);
+  return hash;
+}
+
+/*
+ * Image of board under symmetry, or with inverse, the board whose image
+ * board is
+ */
+static NonoGramBoard *_transform(
+  NonoGramBoard *board,
+  int symmetry,
+  bool inverse
+) {
+  bool transpose = symmetry & _TRANSPOSE;
+  NonoGramBoard *result = nonogram_board_create(
+    transpose ? board->cols_count : board->rows_count,
+    transpose ? board->rows_count : board->cols_count
+  );
+  if (!result) {
+    return NULL;
+  }
+  // Dimensions of the board before the symmetry
+  NonoGramBoard *source = inverse ? result : board;
+  int rows_count = source->rows_count;
+  int cols_count = source->cols_count;
+  for (int row = 0; row < rows_count; row++) {
+    for (int col = 0; col < cols_count; col++) {
+      int image_row = symmetry & _MIRROR_ROWS ? rows_count - 1 - row : row;
+      int image_col = symmetry & _MIRROR_COLS ? cols_count - 1 - col : col;
+      if (transpose) {
+        int swapped = image_row;
+        image_row = image_col;
+        image_col = swapped;
+      }
+      if (inverse) {
+        nonogram_board_set(
+          result, row, col, nonogram_board_get(board, image_row, image_col)
+        );
+      } else {
+        nonogram_board_set(
+          result, image_row, image_col, nonogram_board_get(board, row, col)
+        );
+      }
+    }
+  }
+  return result;
+}
+
+static bool _equal(NonoGramHints *first, NonoGramHints *second) {
+  int lines_count = first->rows_count + first->cols_count;
+  return first->rows_count == second->rows_count &&
+    first->cols_count == second->cols_count &&
+    !memcmp(first->offsets, second->offsets, (lines_count + 1) * sizeof(int)) &&
+    !memcmp(
+      first->clues,
+      second->clues,
+      first->offsets[lines_count] * sizeof(int)
+    );
+}
+
+/* Path of the entry of hash in cache, or of a temporary file for it */
+static char *_entry_path(NonoGramCache *cache, uint64_t hash, bool temporary) {
+  size_t size = strlen(cache->path) + 32;
+  char *path = malloc(size);
+  if (path) {
+    snprintf(
+      path,
+      size,
+      temporary ? "%s/.%016llx.XXXXXX" : "%s/%016llx.ngra",
+      cache->path,
+      (unsigned long long)hash
+    );
+  }
+  return path;
+}
+
+NonoGramCache *nonogram_cache_open(const char *path) {
+  struct stat status;
+  if ((mkdir(path, 0777) && errno != EEXIST) ||
+      stat(path, &status) || !S_ISDIR(status.st_mode)) {
+    return NULL;
+  }
+  NonoGramCache *cache = malloc(sizeof(NonoGramCache));
+  if (!cache) {
+    return NULL;
+  }
+  cache->path = strdup(path);
+  if (!cache->path) {
+    free(cache);
+    return NULL;
+  }
+  return cache;
+}
+
+void nonogram_cache_close(NonoGramCache *cache) {
+  free(cache->path);
+  free(cache);
+}
+
+NonoGramBoard *nonogram_cache_get(NonoGramCache *cache, NonoGramHints *hints) {
+  int symmetry;
+  NonoGramHints *canonical = _canonical(hints, &symmetry);
+  if (!canonical) {
+    return NULL;
+  }
+  char *path = _entry_path(cache, _hash(canonical), false);
+  NonoGramArchive *archive = path ? nonogram_archive_open(path) : NULL;
+  free(path);
+  NonoGramHints *stored = NULL;
+  NonoGramBoard *solution = NULL;
+  NonoGramBoard *result = NULL;
+  if (archive && nonogram_archive_get_count(archive) == 1 &&
+      nonogram_archive_get(archive, 0, &stored, NULL, &solution) &&
+      solution && _equal(stored, canonical)) {
+    result = _transform(solution, symmetry, true);
+  }
+  if (solution) {
+    nonogram_board_destroy(solution);
+  }
+  if (stored) {
+    nonogram_hints_destroy(stored);
+  }
+  if (archive) {
+    nonogram_archive_close(archive);
+  }
+  nonogram_hints_destroy(canonical);
+  // A damaged entry is a miss
+  if (result && !nonogram_hints_check(hints, result)) {
+    nonogram_board_destroy(result);
+    result = NULL;
+  }
+  return result;
+}
+
+int nonogram_cache_put(
+  NonoGramCache *cache,
+  NonoGramHints *hints,
+  NonoGramBoard *solution
+) {
+  if (solution->rows_count != hints->rows_count ||
+      solution->cols_count != hints->cols_count ||
+      nonogram_board_get_unknown_count(solution) ||
+      !nonogram_hints_check(hints, solution)) {
+    return 0;
+  }
+  int symmetry;
+  NonoGramHints *canonical = _canonical(hints, &symmetry);
+  if (!canonical) {
+    return 0;
+  }
+  uint64_t hash = _hash(canonical);
+  NonoGramBoard *image = _transform(solution, symmetry, false);
+  char *temporary = _entry_path(cache, hash, true);
+  char *path = _entry_path(cache, hash, false);
+  int fd = image && temporary && path ? mkstemp(temporary) : -1;
+  FILE *file = fd >= 0 ? fdopen(fd, "wb") : NULL;
+  bool stored = false;
+  if (file) {
+    NonoGramArchiveWriter *writer = nonogram_archive_writer_create(file, 0);
+    stored = writer &&
+      nonogram_archive_writer_add(writer, canonical, NULL, image);
+    if (writer) {
+      stored = nonogram_archive_writer_close(writer) && stored;
+    }
+    stored = !fclose(file) && stored;
+  } else if (fd >= 0) {
+    close(fd);
+  }
+  if (fd >= 0) {
+    stored = stored && !rename(temporary, path);
+    if (!stored) {
+      unlink(temporary);
+    }
+  }
+  free(path);
+  free(temporary);
+  if (image) {
+    nonogram_board_destroy(image);
+  }
+  nonogram_hints_destroy(canonical);
+  return stored;
+}
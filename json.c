@@ -0,0 +1,303 @@
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "./nonogram.h"
+#include "./nonogram.inc"
+
+/*
+ * Streaming parser for {"rows":[[...],...],"cols":[[...],...]}: clues are
+ * appended to flat arrays as they are tokenized, no document tree is built.
+ */
+
+typedef struct {
+  FILE *file;
+  const char *current;
+  const char *end;
+  char buffer[BUFSIZ];
+} _Reader;
+
+typedef struct {
+  int *clues;          // Clues of every line, one after the other
+  int clues_count;
+  int clues_capacity;
+  int *counts;         // Number of clues of each line
+  int lines_count;
+  int lines_capacity;
+} _Lines;
+
+static int _peek(_Reader *reader) {
+  if (reader->current == reader->end) {
+    if (!reader->file) {
+      return EOF;
+    }
+    size_t size = fread(reader->buffer, 1, sizeof reader->buffer, reader->file);
+    if (!size) {
+      return EOF;
+    }
+    reader->current = reader->buffer;
+    reader->end = reader->buffer + size;
+  }
+  return (unsigned char)*reader->current;
+}
+
+static int _next(_Reader *reader) {
+  int c = _peek(reader);
+  if (c != EOF) {
+    reader->current++;
+  }
+  return c;
+}
+
+static int _skip_spaces(_Reader *reader) {
+  int c = _peek(reader);
+  while (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+    reader->current++;
+    c = _peek(reader);
+  }
+  return c;
+}
+
+static bool _expect(_Reader *reader, int expected) {
+  if (_skip_spaces(reader) != expected) {
+    return false;
+  }
+  reader->current++;
+  return true;
+}
+
+static bool _grow(int **array, int *capacity, int count) {
+  if (count < *capacity) {
+    return true;
+  }
+  int new_capacity = *capacity ? 2 * *capacity : 64;
+  int *new_array = realloc(*array, new_capacity * sizeof(int));
+  if (!new_array) {
+    return false;
+  }
+  *array = new_array;
+  *capacity = new_capacity;
+  return true;
+}
+
+static bool _parse_int(_Reader *reader, int *value) {
+  int c = _skip_spaces(reader);
+  if (!isdigit(c)) {
+    return false;
+  }
+  long number = 0;
+  while (isdigit(c)) {
+    number = number * 10 + (c - '0');
+    if (number > 0x7fffffff) {
+      return false;
+    }
+    reader->current++;
+    c = _peek(reader);
+  }
+  // Clues are integers: no fraction or exponent
+  if (c == '.' || c == 'e' || c == 'E') {
+    return false;
+  }
+  *value = (int)number;
+  return true;
+}
+
+/* Reads a string into key, truncated to size - 1 characters */
+static bool _parse_string(_Reader *reader, char *key, size_t size) {
+  if (!_expect(reader, '"')) {
+    return false;
+  }
+  size_t length = 0;
+  int c;
+  while ((c = _next(reader)) != '"') {
+    if (c == EOF || c < ' ') {
+      return false;
+    }
+    if (c == '\\' && _next(reader) == EOF) {
+      return false;
+    }
+    if (length + 1 < size) {
+      key[length++] = (char)c;
+    }
+  }
+  if (size) {
+    key[length] = '\0';
+  }
+  return true;
+}
+
+static bool _skip_value(_Reader *reader, int depth) {
+  if (depth > 64) {
+    return false;
+  }
+  int c = _skip_spaces(reader);
+  if (c == '"') {
+    return _parse_string(reader, NULL, 0);
+  }
+  if (c == '[' || c == '{') {
+    int close = c == '[' ? ']' : '}';
+    reader->current++;
+    if (_skip_spaces(reader) == close) {
+      reader->current++;
+      return true;
+    }
+    do {
+      if (close == '}' &&
+          (!_parse_string(reader, NULL, 0) || !_expect(reader, ':'))) {
+        return false;
+      }
+      if (!_skip_value(reader, depth + 1)) {
+        return false;
+      }
+    } while (_expect(reader, ','));
+    return _expect(reader, close);
+  }
+  // Numbers and literals
+  bool empty = true;
+  while (c != EOF && (isalnum(c) || c == '-' || c == '+' || c == '.')) {
+    reader->current++;
+    c = _peek(reader);
+    empty = false;
+  }
+  return !empty;
+}
+
+static bool _parse_line(_Reader *reader, _Lines *lines) {
+  if (!_expect(reader, '[')) {
+    return false;
+  }
+  int count = 0;
+  int values = 0;
+  bool zero = false;
+  if (_skip_spaces(reader) != ']') {
+    do {
+      int clue;
+      if (!_parse_int(reader, &clue)) {
+        return false;
+      }
+      values++;
+      zero |= clue == 0;
+      if (clue > 0) {
+        if (!_grow(&lines->clues, &lines->clues_capacity,
+                   lines->clues_count)) {
+          return false;
+        }
+        lines->clues[lines->clues_count++] = clue;
+        count++;
+      }
+    } while (_expect(reader, ','));
+  }
+  // A lone 0 is a common way to write an empty line, but no clue is 0
+  if (!_expect(reader, ']') || (zero && values > 1)) {
+    return false;
+  }
+  if (!_grow(&lines->counts, &lines->lines_capacity, lines->lines_count)) {
+    return false;
+  }
+  lines->counts[lines->lines_count++] = count;
+  return true;
+}
+
+static bool _parse_lines(_Reader *reader, _Lines *lines) {
+  if (!_expect(reader, '[')) {
+    return false;
+  }
+  if (_skip_spaces(reader) != ']') {
+    do {
+      if (!_parse_line(reader, lines)) {
+        return false;
+      }
+    } while (_expect(reader, ','));
+  }
+  return _expect(reader, ']');
+}
+
+/* Every line of lines has clues that fit in length cells */
+static bool _lines_fit(const _Lines *lines, int length) {
+  const int *clues = lines->clues;
+  for (int line = 0; line < lines->lines_count; line++) {
+    if (!_nonogram_line_fits(clues, lines->counts[line], length)) {
+      return false;
+    }
+    clues += lines->counts[line];
+  }
+  return true;
+}
+
+static int *_copy_lines(const _Lines *lines, int *offsets, int *clues) {
+  if (lines->clues_count) {
+    memcpy(clues, lines->clues, lines->clues_count * sizeof(int));
+  }
+  for (int line = 0; line < lines->lines_count; line++) {
+    offsets[line + 1] = offsets[line] + lines->counts[line];
+  }
+  return clues + lines->clues_count;
+}
+
+static NonoGramHints *_parse(_Reader *reader) {
+  _Lines rows = {0};
+  _Lines cols = {0};
+  bool has_rows = false;
+  bool has_cols = false;
+  bool valid = _expect(reader, '{');
+  if (valid && _skip_spaces(reader) != '}') {
+    do {
+      char key[8];
+      valid = _parse_string(reader, key, sizeof key) && _expect(reader, ':');
+      if (!valid) {
+        break;
+      }
+      if (!strcmp(key, "rows") && !has_rows) {
+        valid = _parse_lines(reader, &rows);
+        has_rows = true;
+      } else if (!strcmp(key, "cols") && !has_cols) {
+        valid = _parse_lines(reader, &cols);
+        has_cols = true;
+      } else {
+        valid = _skip_value(reader, 0);
+      }
+    } while (valid && _expect(reader, ','));
+  }
+  valid = valid && _expect(reader, '}') && has_rows && has_cols &&
+    _lines_fit(&rows, cols.lines_count) && _lines_fit(&cols, rows.lines_count);
+
+  NonoGramHints *hints = NULL;
+  if (valid) {
+    hints = _nonogram_hints_new(
+      rows.lines_count,
+      cols.lines_count,
+      rows.clues_count + cols.clues_count
+    );
+  }
+  if (hints) {
+    int *clues = _copy_lines(&rows, hints->offsets, hints->clues);
+    _copy_lines(&cols, hints->offsets + rows.lines_count, clues);
+  }
+  free(rows.clues);
+  free(rows.counts);
+  free(cols.clues);
+  free(cols.counts);
+  return hints;
+}
+
+NonoGramHints *nonogram_hints_parse(const char *string) {
+  _Reader reader;
+  reader.file = NULL;
+  reader.current = string;
+  reader.end = string + strlen(string);
+  return _parse(&reader);
+}
+
+NonoGramHints *nonogram_hints_read(FILE *file) {
+  _Reader *reader = malloc(sizeof(_Reader));
+  if (!reader) {
+    return NULL;
+  }
+  reader->file = file;
+  reader->current = reader->end = reader->buffer;
+  NonoGramHints *hints = _parse(reader);
+  free(reader);
+  return hints;
+}
@@ -0,0 +1,237 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "./nonogram.h"
+#include "./nonogram.inc"
+
+/*
+ * Memo tables keep the outcome of recent line solves, keyed by the clues and
+ * the known cells of the line as a pair of bit planes. Entries sit in sets of
+ * _MEMO_WAYS ways picked by the hash of the key; a set full of entries drops
+ * one the clock way: its hand passes over the ways that were used since it
+ * last came by, clearing their mark, and stops on the first one that was
+ * not. Each way keeps its record in a buffer of its own, which is only
+ * reallocated for a longer record, so a warm table stops asking malloc for
+ * anything.
+ *
+ * A record holds the clues, the planes of the line as given, then, unless it
+ * contradicts its clues, the planes of the line as solved.
+ */
+
+#define _MEMO_WAYS 4
+#define _MEMO_ENTRIES (16 * 1024)
+
+typedef struct {
+  uint64_t hash;
+  int length;        // Cells in the line, 0 for an empty way
+  int clues_count;
+  int settled;       // Cells settled, or -1 on contradiction
+  bool referenced;   // Used since the hand last passed
+  uint64_t *record;
+  size_t capacity;   // Words in record
+} _Way;
+
+struct _NonoGramMemo {
+  _Way *ways;
+  unsigned char *hands;  // Clock hand of each set
+  size_t sets_count;     // A power of two
+  uint64_t *key;         // Record of the line last looked up
+  size_t key_capacity;
+  size_t key_words;      // Words of key holding the clues and given planes
+  uint64_t hash;         // Hash of key
+  int length;
+  int clues_count;
+};
+
+_Thread_local NonoGramMemo *_nonogram_memo = NULL;
+
+NonoGramMemo *nonogram_memo_create(size_t entries) {
+  if (!entries) {
+    entries = _MEMO_ENTRIES;
+  }
+  size_t sets_count = 1;
+  while (sets_count * _MEMO_WAYS < entries && sets_count < SIZE_MAX / 4) {
+    sets_count *= 2;
+  }
+  NonoGramMemo *memo = calloc(1, sizeof(NonoGramMemo));
+  if (!memo) {
+    return NULL;
+  }
+  memo->ways = calloc(sets_count * _MEMO_WAYS, sizeof(_Way));
+  memo->hands = calloc(sets_count, 1);
+  if (!memo->ways || !memo->hands) {
+    free(memo->ways);
+    free(memo->hands);
+    free(memo);
+    return NULL;
+  }
+  memo->sets_count = sets_count;
+  return memo;
+}
+
+void nonogram_memo_destroy(NonoGramMemo *memo) {
+  if (_nonogram_memo == memo) {
+    _nonogram_memo = NULL;
+  }
+  for (size_t way = 0; way < memo->sets_count * _MEMO_WAYS; way++) {
+    free(memo->ways[way].record);
+  }
+  free(memo->ways);
+  free(memo->hands);
+  free(memo->key);
+  free(memo);
+}
+
+void nonogram_memo_clear(NonoGramMemo *memo) {
+  for (size_t way = 0; way < memo->sets_count * _MEMO_WAYS; way++) {
+    memo->ways[way].length = 0;
+    memo->ways[way].referenced = false;
+  }
+  memset(memo->hands, 0, memo->sets_count);
+}
+
+size_t nonogram_memo_get_size(NonoGramMemo *memo) {
+  return memo->sets_count * _MEMO_WAYS;
+}
+
+NonoGramMemo *nonogram_memo_use(NonoGramMemo *memo) {
+  NonoGramMemo *previous = _nonogram_memo;
+  _nonogram_memo = memo;
+  return previous;
+}
+
+static bool _reserve(uint64_t **words, size_t *capacity, size_t needed) {
+  if (needed <= *capacity) {
+    return true;
+  }
+  uint64_t *grown = realloc(*words, needed * sizeof(uint64_t));
+  if (!grown) {
+    return false;
+  }
+  *words = grown;
+  *capacity = needed;
+  return true;
+}
+
+/* splitmix64 finalizer, to spread the bits of each word over the hash */
+static uint64_t _mix(uint64_t hash, uint64_t word) {
+  hash = (hash ^ word) * 0x9e3779b97f4a7c15;
+  hash ^= hash >> 30;
+  hash *= 0xbf58476d1ce4e5b9;
+  return hash ^ hash >> 27;
+}
+
+/* Pack the known filled and empty cells of line into planes */
+static void _pack(
+  const int *line,
+  int length,
+  uint64_t *filled,
+  uint64_t *empty
+) {
+  int words = _NONOGRAM_WORDS(length);
+  memset(filled, 0, words * sizeof(uint64_t));
+  memset(empty, 0, words * sizeof(uint64_t));
+  for (int cell = 0; cell < length; cell++) {
+    if (line[cell] == NONOGRAM_FILLED) {
+      filled[cell / _NONOGRAM_WORD_BITS] |= _NONOGRAM_BIT(cell);
+    } else if (line[cell] == NONOGRAM_EMPTY) {
+      empty[cell / _NONOGRAM_WORD_BITS] |= _NONOGRAM_BIT(cell);
+    }
+  }
+}
+
+bool _nonogram_memo_find(
+  NonoGramMemo *memo,
+  const int *clues,
+  int clues_count,
+  int *line,
+  int length,
+  int *settled
+) {
+  size_t clues_words = ((size_t)clues_count + 1) / 2;
+  size_t plane_words = _NONOGRAM_WORDS(length);
+  memo->length = 0;
+  if (!_reserve(
+        &memo->key,
+        &memo->key_capacity,
+        clues_words + 2 * plane_words
+      )) {
+    return false;
+  }
+  uint64_t *key = memo->key;
+  if (clues_count % 2) {
+    key[clues_words - 1] = 0;
+  }
+  memcpy(key, clues, clues_count * sizeof(int));
+  _pack(line, length, key + clues_words, key + clues_words + plane_words);
+  memo->key_words = clues_words + 2 * plane_words;
+  uint64_t hash = _mix((uint64_t)length, (uint64_t)clues_count);
+  for (size_t word = 0; word < memo->key_words; word++) {
+    hash = _mix(hash, key[word]);
+  }
+  memo->hash = hash;
+  memo->length = length;
+  memo->clues_count = clues_count;
+
+  _Way *ways = memo->ways + (hash & (memo->sets_count - 1)) * _MEMO_WAYS;
+  for (int index = 0; index < _MEMO_WAYS; index++) {
+    _Way *way = &ways[index];
+    if (way->hash != hash || way->length != length ||
+        way->clues_count != clues_count ||
+        memcmp(way->record, key, memo->key_words * sizeof(uint64_t))) {
+      continue;
+    }
+    way->referenced = true;
+    *settled = way->settled;
+    if (way->settled > 0) {
+      const uint64_t *filled = way->record + memo->key_words;
+      const uint64_t *empty = filled + plane_words;
+      for (int cell = 0; cell < length; cell++) {
+        int word = cell / _NONOGRAM_WORD_BITS;
+        uint64_t bit = _NONOGRAM_BIT(cell);
+        if (filled[word] & bit) {
+          line[cell] = NONOGRAM_FILLED;
+        } else if (empty[word] & bit) {
+          line[cell] = NONOGRAM_EMPTY;
+        }
+      }
+    }
+    return true;
+  }
+  return false;
+}
+
+void _nonogram_memo_store(NonoGramMemo *memo, const int *line, int settled) {
+  int length = memo->length;
+  if (!length) {
+    return;
+  }
+  memo->length = 0;
+  size_t set = memo->hash & (memo->sets_count - 1);
+  _Way *ways = memo->ways + set * _MEMO_WAYS;
+  unsigned char *hand = &memo->hands[set];
+  while (ways[*hand].referenced) {
+    ways[*hand].referenced = false;
+    *hand = (*hand + 1) % _MEMO_WAYS;
+  }
+  _Way *way = &ways[*hand];
+  *hand = (*hand + 1) % _MEMO_WAYS;
+
+  size_t plane_words = _NONOGRAM_WORDS(length);
+  size_t words = memo->key_words + (settled > 0 ? 2 * plane_words : 0);
+  way->length = 0;
+  if (!_reserve(&way->record, &way->capacity, words)) {
+    return;
+  }
+  memcpy(way->record, memo->key, memo->key_words * sizeof(uint64_t));
+  if (settled > 0) {
+    uint64_t *filled = way->record + memo->key_words;
+    _pack(line, length, filled, filled + plane_words);
+  }
+  way->hash = memo->hash;
+  way->length = length;
+  way->clues_count = memo->clues_count;
+  way->settled = settled;
+}
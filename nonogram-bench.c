@@ -0,0 +1,302 @@
+#include <ctype.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "pnmio.h" // Include the libpnmio header file
+#include "nonogram.h"
+
+// Phases timed for every puzzle of the corpus
+enum {
+    PHASE_HINTS,     // Hints from the PBM raster
+    PHASE_FORMAT,    // Hints to JSON
+    PHASE_PARSE,     // JSON to hints
+    PHASE_PBM,       // PBM file to board
+    PHASE_SOLVE,     // Line logic from an empty board
+    PHASE_PROBE,     // Probing what line logic leaves unknown
+    PHASE_SEARCH,    // Search on what is still unknown
+    PHASE_COUNT
+};
+
+static const char *phase_names[PHASE_COUNT] = {
+    "hints", "format", "parse", "pbm", "solve", "probe", "search",
+};
+
+// Samples of one phase, in nanoseconds
+typedef struct {
+    double *values;
+    int count;
+} Samples;
+
+// Function to draw the next number of a splitmix64 sequence, so that the
+// corpus only depends on the seed
+static uint64_t next_random(uint64_t *state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+}
+
+static double now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec * 1e9 + time.tv_nsec;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Function to generate a PBM file in memory: a random size x size board,
+// each cell black with the given density
+static unsigned char *generate_pbm(uint64_t *state, int size, double density, size_t *length) {
+    char header[32];
+    int header_length = snprintf(header, sizeof header, "P4\n%d %d\n", size, size);
+    size_t stride = (size + 7) / 8;
+    *length = header_length + stride * size;
+    unsigned char *pbm = (unsigned char *)calloc(*length, 1);
+    if (pbm == NULL) {
+        return NULL;
+    }
+    memcpy(pbm, header, header_length);
+    uint64_t threshold = (uint64_t)(density * 18446744073709551615.0);
+    for (int row = 0; row < size; row++) {
+        for (int col = 0; col < size; col++) {
+            if (next_random(state) < threshold) {
+                pbm[header_length + row * stride + col / 8] |= 0x80 >> (col % 8);
+            }
+        }
+    }
+    return pbm;
+}
+
+// Function to read the next number of a PBM header, skipping whitespace and
+// comment lines. Returns -1 if there is none.
+static int read_header_number(FILE *file) {
+    int c = fgetc(file);
+    while (isspace(c) || c == '#') {
+        if (c == '#') {
+            while (c != '\n' && c != EOF) {
+                c = fgetc(file);
+            }
+        }
+        c = fgetc(file);
+    }
+    int value = -1;
+    while (isdigit(c) && value < INT_MAX / 10) {
+        value = (value < 0 ? 0 : 10 * value) + c - '0';
+        c = fgetc(file);
+    }
+    // The single whitespace after the last number is part of the header
+    return isspace(c) ? value : -1;
+}
+
+// Function to read a PBM header as read_pbm_header does, comment lines
+// included, but without printing it, nor exiting on a bad one
+static bool read_header(FILE *file, int *cols_count, int *rows_count, int *is_ascii) {
+    char magic[2];
+    if (fread(magic, 1, sizeof magic, file) != sizeof magic || magic[0] != 'P' ||
+        (magic[1] != '1' && magic[1] != '4')) {
+        return false;
+    }
+    *is_ascii = magic[1] == '1';
+    *cols_count = read_header_number(file);
+    *rows_count = *cols_count > 0 ? read_header_number(file) : -1;
+    return *rows_count > 0;
+}
+
+// Function to time every phase on one puzzle, adding a sample per phase.
+// Returns false if the puzzle could not be solved.
+static bool bench_puzzle(const unsigned char *pbm, size_t length, Samples *samples, bool probe) {
+    double start, times[PHASE_COUNT] = {0};
+    bool solved = false;
+
+    // PBM load: header, raster read with libpnmio as nonogram-solve reads
+    // board files, then the bit-packed board
+    start = now();
+    FILE *file = fmemopen((void *)pbm, length, "rb");
+    int cols_count = 0, rows_count = 0, is_ascii = 0;
+    unsigned char *bits = NULL;
+    NonoGramBoard *image = NULL;
+    if (file != NULL && read_header(file, &cols_count, &rows_count, &is_ascii)) {
+        bits = (unsigned char *)malloc((size_t)(cols_count + 7) / 8 * rows_count);
+        if (bits != NULL && read_pbm_bits(file, bits, cols_count, rows_count, is_ascii) != FALSE) {
+            image = nonogram_board_create_from_bitmap(bits, rows_count, cols_count);
+        }
+    }
+    if (file != NULL) {
+        fclose(file);
+    }
+    times[PHASE_PBM] = now() - start;
+
+    start = now();
+    NonoGramHints *hints = image != NULL ? nonogram_hints_create_from_bitmap(bits, rows_count, cols_count) : NULL;
+    times[PHASE_HINTS] = now() - start;
+
+    if (hints != NULL) {
+        start = now();
+        size_t size = nonogram_hints_format(hints, NULL, 0) + 1;
+        char *json = (char *)malloc(size);
+        if (json != NULL) {
+            nonogram_hints_format(hints, json, size);
+        }
+        times[PHASE_FORMAT] = now() - start;
+
+        start = now();
+        NonoGramHints *parsed = json != NULL ? nonogram_hints_parse(json) : NULL;
+        times[PHASE_PARSE] = now() - start;
+        free(json);
+
+        NonoGramBoard *board = nonogram_board_create(rows_count, cols_count);
+        if (parsed != NULL && board != NULL) {
+            start = now();
+            int unknown = nonogram_hints_solve(parsed, board);
+            times[PHASE_SOLVE] = now() - start;
+
+            if (unknown > 0 && probe) {
+                start = now();
+                unknown = nonogram_hints_probe(parsed, board);
+                times[PHASE_PROBE] = now() - start;
+            }
+
+            if (unknown > 0) {
+                start = now();
+                solved = nonogram_hints_search(parsed, board) == 1;
+                times[PHASE_SEARCH] = now() - start;
+            } else {
+                solved = unknown == 0;
+            }
+        }
+        if (board != NULL) {
+            nonogram_board_destroy(board);
+        }
+        if (parsed != NULL) {
+            nonogram_hints_destroy(parsed);
+        }
+        nonogram_hints_destroy(hints);
+    }
+    if (image != NULL) {
+        nonogram_board_destroy(image);
+    }
+    free(bits);
+
+    for (int phase = 0; phase < PHASE_COUNT; phase++) {
+        samples[phase].values[samples[phase].count++] = times[phase];
+    }
+    return solved;
+}
+
+// Function to parse a comma-separated list of numbers, such as "10,20,30"
+static int parse_list(const char *text, double *values, int max) {
+    int count = 0;
+    while (*text != '\0' && count < max) {
+        char *end;
+        values[count++] = strtod(text, &end);
+        if (end == text || (*end != ',' && *end != '\0')) {
+            return 0;
+        }
+        text = *end == ',' ? end + 1 : end;
+    }
+    return count;
+}
+
+void print_usage(const char *program_name) {
+    printf("Usage: %s [--sizes <n,...>] [--densities <d,...>] [--count <puzzles>] [--repeat <count>] "
+           "[--seed <seed>] [--probe]\n",
+           program_name);
+}
+
+int main(int argc, char *argv[]) {
+    double sizes[16] = {10, 15, 20};
+    double densities[16] = {0.5, 0.6, 0.7};
+    int sizes_count = 3, densities_count = 3;
+    long count = 20, repeat = 5;
+    unsigned long long seed = 2024;
+    bool probe = false;
+
+    // Parse command-line arguments
+    for (int i = 1; i < argc; i++) {
+        bool valid = i + 1 < argc;
+        if (strcmp(argv[i], "--probe") == 0) {
+            probe = true;
+            continue;
+        } else if (valid && strcmp(argv[i], "--sizes") == 0) {
+            valid = (sizes_count = parse_list(argv[++i], sizes, 16)) > 0;
+        } else if (valid && strcmp(argv[i], "--densities") == 0) {
+            valid = (densities_count = parse_list(argv[++i], densities, 16)) > 0;
+        } else if (valid && strcmp(argv[i], "--count") == 0) {
+            valid = (count = strtol(argv[++i], NULL, 10)) > 0;
+        } else if (valid && strcmp(argv[i], "--repeat") == 0) {
+            valid = (repeat = strtol(argv[++i], NULL, 10)) > 0;
+        } else if (valid && strcmp(argv[i], "--seed") == 0) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else {
+            valid = false;
+        }
+        if (!valid) {
+            fprintf(stderr, "Error: Missing or invalid argument: %s\n", argv[i]);
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    Samples samples[PHASE_COUNT];
+    for (int phase = 0; phase < PHASE_COUNT; phase++) {
+        samples[phase].values = (double *)malloc(count * repeat * sizeof(double));
+        if (samples[phase].values == NULL) {
+            fprintf(stderr, "Error: Memory allocation failed.\n");
+            return 1;
+        }
+    }
+
+    // One corpus per size and density, each drawn from its own sequence so
+    // that changing the lists leaves the other corpora as they were
+    int failed = 0;
+    printf("%-6s %-8s %-7s %12s %12s %12s\n", "size", "density", "phase", "min_us", "median_us", "p99_us");
+    for (int s = 0; s < sizes_count; s++) {
+        for (int d = 0; d < densities_count; d++) {
+            int size = (int)sizes[s];
+            double density = densities[d];
+            uint64_t state = seed ^ ((uint64_t)size << 32) ^ (uint64_t)(density * 1000);
+            for (int phase = 0; phase < PHASE_COUNT; phase++) {
+                samples[phase].count = 0;
+            }
+            for (long puzzle = 0; puzzle < count; puzzle++) {
+                size_t length;
+                unsigned char *pbm = size > 0 ? generate_pbm(&state, size, density, &length) : NULL;
+                if (pbm == NULL) {
+                    fprintf(stderr, "Error: Failed to generate a %dx%d puzzle.\n", size, size);
+                    return 1;
+                }
+                for (long round = 0; round < repeat; round++) {
+                    failed += !bench_puzzle(pbm, length, samples, probe);
+                }
+                free(pbm);
+            }
+
+            // Phases a puzzle does not need, such as search after line logic
+            // solved it, count as 0
+            for (int phase = 0; phase < PHASE_COUNT; phase++) {
+                Samples *sample = &samples[phase];
+                qsort(sample->values, sample->count, sizeof(double), compare_doubles);
+                int p99 = (int)((sample->count - 1) * 0.99 + 0.5);
+                printf("%-6d %-8.2f %-7s %12.1f %12.1f %12.1f\n", size, density, phase_names[phase],
+                       sample->values[0] / 1e3, sample->values[(sample->count - 1) / 2] / 1e3,
+                       sample->values[p99] / 1e3);
+            }
+        }
+    }
+
+    for (int phase = 0; phase < PHASE_COUNT; phase++) {
+        free(samples[phase].values);
+    }
+    if (failed > 0) {
+        fprintf(stderr, "Error: %d runs did not end with a solution.\n", failed);
+        return 1;
+    }
+    return 0;
+}
@@ -1,246 +1,443 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include <stdbool.h>
-#include <string.h>
-#include "pnmio.h" // Include the libpnmio header file
-#include "cJSON.h" // Include the cJSON header file
-
-// Structure to represent Nonogram hints
-typedef struct {
-    int **rows;
-    int **cols;
-    int rows_count;
-    int cols_count;
-} NonoGramHints;
-
-// Function to calculate hints from the image array
-NonoGramHints *calculate_hints(const int **image, int rows_count, int cols_count) {
-    NonoGramHints *hints = malloc(sizeof(NonoGramHints));
-    if (hints == NULL) {
-        fprintf(stderr, "Error: Memory allocation failed.\n");
-        return NULL;
-    }
-
-    // Allocate memory for row hints
-    hints->rows = malloc(rows_count * sizeof(int *));
-    if (hints->rows == NULL) {
-        free(hints);
-        fprintf(stderr, "Error: Memory allocation failed.\n");
-        return NULL;
-    }
-
-    // Allocate memory for column hints
-    hints->cols = malloc(cols_count * sizeof(int *));
-    if (hints->cols == NULL) {
-        free(hints->rows);
-        free(hints);
-        fprintf(stderr, "Error: Memory allocation failed.\n");
-        return NULL;
-    }
-
-    // Initialize rows and cols counts
-    hints->rows_count = rows_count;
-    hints->cols_count = cols_count;
-
-    // Calculate row hints
-    for (int i = 0; i < rows_count; i++) {
-        hints->rows[i] = malloc(cols_count * sizeof(int));
-        if (hints->rows[i] == NULL) {
-            free(hints->rows);
-            free(hints->cols);
-            free(hints);
-            fprintf(stderr, "Error: Memory allocation failed.\n");
-            return NULL;
-        }
-
-        int count = 0;
-        for (int j = 0; j < cols_count; j++) {
-            if (image[i][j] == 1) {
-                count++;
-            } else if (count > 0) {
-                hints->rows[i][hints->rows[i][0]++] = count;
-                count = 0;
-            }
-        }
-        if (count > 0) {
-            hints->rows[i][hints->rows[i][0]++] = count;
-        }
-    }
-
-    // Calculate column hints
-    for (int j = 0; j < cols_count; j++) {
-        hints->cols[j] = malloc(rows_count * sizeof(int));
-        if (hints->cols[j] == NULL) {
-            for (int i = 0; i < rows_count; i++) {
-                free(hints->rows[i]);
-            }
-            free(hints->rows);
-            free(hints);
-            fprintf(stderr, "Error: Memory allocation failed.\n");
-            return NULL;
-        }
-
-        int count = 0;
-        for (int i = 0; i < rows_count; i++) {
-            if (image[i][j] == 1) {
-                count++;
-            } else if (count > 0) {
-                hints->cols[j][hints->cols[j][0]++] = count;
-                count = 0;
-            }
-        }
-        if (count > 0) {
-            hints->cols[j][hints->cols[j][0]++] = count;
-        }
-    }
-
-    return hints;
-}
-
-// Function to generate a JSON file containing the hints
-void generate_hints_json(const char *hints_file, const NonoGramHints *hints) {
-    // Create a cJSON object to represent the hints
-    cJSON *json_hints = cJSON_CreateObject();
-    if (json_hints == NULL) {
-        fprintf(stderr, "Error: Failed to create cJSON object for hints.\n");
-        return;
-    }
-
-    // Add row hints to the JSON
-    cJSON *rows_array = cJSON_AddArrayToObject(json_hints, "rows");
-    for (int i = 0; i < hints->rows_count; i++) {
-        cJSON *row_array = cJSON_CreateIntArray(hints->rows[i], hints->cols_count);
-        cJSON_AddItemToArray(rows_array, row_array);
-    }
-
-    // Add column hints to the JSON
-    cJSON *cols_array = cJSON_AddArrayToObject(json_hints, "cols");
-    for (int i = 0; i < hints->cols_count; i++) {
-        cJSON *col_array = cJSON_CreateIntArray(hints->cols[i], hints->rows_count);
-        cJSON_AddItemToArray(cols_array, col_array);
-    }
-
-    // Write the JSON to a file
-    FILE *file = fopen(hints_file, "w");
-    if (file != NULL) {
-        char *json_str = cJSON_Print(json_hints);
-        if (json_str != NULL) {
-            fprintf(file, "%s\n", json_str);
-            free(json_str);
-        } else {
-            fprintf(stderr, "Error: Failed to convert cJSON to string.\n");
-        }
-        fclose(file);
-    } else {
-        fprintf(stderr, "Error: Failed to open JSON hints file for writing.\n");
-    }
-
-    // Free the memory used by cJSON
-    cJSON_Delete(json_hints);
-}
-
-// Function to generate a PBM file adding some blackened cells if necessary
-void generate_board_pbm(const char *board_file, const int **image, int rows_count, int cols_count) {
-    FILE *file = fopen(board_file, "w");
-    if (file == NULL) {
-        fprintf(stderr, "Error: Failed to open PBM board file for writing.\n");
-        return;
-    }
-
-    // Write PBM header
-    fprintf(file, "P1\n%d %d\n", cols_count, rows_count);
-
-    // Write image data to the PBM file
-    for (int i = 0; i < rows_count; i++) {
-        for (int j = 0; j < cols_count; j++) {
-            fprintf(file, "%d ", image[i][j]);
-        }
-        fprintf(file, "\n");
-    }
-
-    fclose(file);
-}
-
-// Function to generate an SVG file representing the puzzle
-void generate_svg(const char *output_file, const int **image, int rows_count, int cols_count) {
-    FILE *file;
-
-    // Open the output file for writing or use stdout if output_file is NULL
-    if (output_file != NULL) {
-        file = fopen(output_file, "w");
-        if (file == NULL) {
-            fprintf(stderr, "Error: Failed to open output file for writing.\n");
-            return;
-        }
-    } else {
-        file = stdout;
-    }
-
-    // Write the SVG header
-    if (output_file != NULL) {
-        fprintf(file, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
-        fprintf(file, "<!DOCTYPE svg PUBLIC \"-//W3C//DTD SVG 1.1//EN\" \"http://www.w3.org/Graphics/SVG/1.1/DTD/svg11.dtd\">\n");
-    }
-    fprintf(file, "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%d\" height=\"%d\" version=\"1.1\">\n", cols_count * 20, rows_count * 20);
-
-    // Loop through the image array to generate SVG rectangles
-    for (int i = 0; i < rows_count; i++) {
-        for (int j = 0; j < cols_count; j++) {
-            if (image[i][j] == 1) {
-                fprintf(file, "<rect x=\"%d\" y=\"%d\" width=\"20\" height=\"20\" fill=\"black\" stroke=\"black\"/>\n", j * 20, i * 20);
-            } else {
-                fprintf(file, "<rect x=\"%d\" y=\"%d\" width=\"20\" height=\"20\" fill=\"white\" stroke=\"black\"/>\n", j * 20, i * 20);
-            }
-        }
-    }
-
-    // Write the SVG footer
-    fprintf(file, "</svg>\n");
-
-    // Close the output file if it's not stdout
-    if (output_file != NULL) {
-        fclose(file);
-    }
-}
-
-int main(int argc, char *argv[]) {
-    // Check the number of arguments
-    if (argc < 2) {
-        fprintf(stderr, "Error: Not enough arguments.\n");
-        // Print usage message
-        return 1;
-    }
-
-    // Get the input PBM image file name
-    const char *image_file = argv[1];
-
-    // Read the PBM image file to get the data
-    int **image = NULL;
-    int rows_count = 0, cols_count = 0;
-    image = parse_pbm_board_libpnmio(image_file, &rows_count, &cols_count);
-    if (image == NULL) {
-        fprintf(stderr, "Error: Failed to parse PBM image.\n");
-        return 1;
-    }
-
-   //  Calculate hints from the image data
-    //NonoGramHints *hints = calculate_hints((const int **)image, rows_count, cols_count);
-
-     //Optionally, generate a JSON file containing the hints
-    //if (/* condition to generate the JSON file */) {
-     //   generate_hints_json(/* arguments */);
-    //}
-
-    // Optionally, generate a PBM file adding some blackened cells
-    //if (/* condition to generate the PBM file */) {
-       // generate_board_pbm(/* arguments */);
-   // }
-
-    // Generate an SVG file representing the puzzle
-    //generate_svg(/* arguments */);
-
-    // Free the memory used by the image data and hints
-    // ...
-
-    return 0;
-}
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include "pnmio.h" // Include the libpnmio header file
+#include "nonogram.h"
+
+// Structure to represent the image: packed rows as in PBM files, read once
+// and shared by every output
+typedef struct {
+    unsigned char *bits;
+    int rows_count;
+    int cols_count;
+    size_t stride; // Bytes per row
+} Image;
+
+// Function to read a PBM image in one go using libpnmio
+bool parse_pbm_image_libpnmio(const char *image_file, Image *image) {
+    FILE *file = fopen(image_file, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "Error: Failed to open PBM image file.\n");
+        return false;
+    }
+
+    // Read the PBM header to get the dimensions and the image type
+    int img_type = get_pnm_type(file);
+    int is_ascii;
+    rewind(file);
+    if ((img_type != PBM_BINARY && img_type != PBM_ASCII) ||
+        read_pbm_header(file, &image->cols_count, &image->rows_count, &is_ascii) == FALSE) {
+        fprintf(stderr, "Error: Invalid PBM file format.\n");
+        fclose(file);
+        return false;
+    }
+
+    // Read the raster in bulk
+    image->stride = (image->cols_count + 7) / 8;
+    image->bits = (unsigned char *)malloc(image->stride * image->rows_count);
+    if (image->bits == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed.\n");
+        fclose(file);
+        return false;
+    }
+    if (read_pbm_bits(file, image->bits, image->cols_count, image->rows_count, is_ascii) == FALSE) {
+        fprintf(stderr, "Error: Truncated or invalid PBM data.\n");
+        free(image->bits);
+        fclose(file);
+        return false;
+    }
+    fclose(file);
+    return true;
+}
+
+static bool is_black(const Image *image, int row, int col) {
+    return image->bits[row * image->stride + col / 8] >> (7 - col % 8) & 1;
+}
+
+// Function to calculate hints from the image, in a single pass over its rows
+NonoGramHints *calculate_hints(const Image *image) {
+    NonoGramHints *hints = nonogram_hints_create_from_bitmap(image->bits, image->rows_count, image->cols_count);
+    if (hints == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed.\n");
+    }
+    return hints;
+}
+
+// Function to blacken cells of the image on the board until the hints and the
+// board have a single solution. Returns the number of cells blackened, or -1
+// on error
+int blacken_cells(NonoGramHints *hints, NonoGramBoard *board, const Image *image) {
+    int blackened = 0;
+    for (;;) {
+        NonoGramBoard *witnesses[2];
+        int found = nonogram_hints_count_solutions(hints, board, witnesses);
+        if (found < 2) {
+            if (found == 1) {
+                nonogram_board_destroy(witnesses[0]);
+            }
+            return found == 1 ? blackened : -1;
+        }
+
+        // At least one witness is not the image; as rows hold as many black
+        // cells in both, that witness leaves a black cell of the image white
+        int row = -1, col = -1;
+        for (int i = 0; i < image->rows_count && row < 0; i++) {
+            for (int j = 0; j < image->cols_count; j++) {
+                if (is_black(image, i, j) && (nonogram_board_get(witnesses[0], i, j) == NONOGRAM_EMPTY ||
+                                              nonogram_board_get(witnesses[1], i, j) == NONOGRAM_EMPTY)) {
+                    row = i;
+                    col = j;
+                    break;
+                }
+            }
+        }
+        nonogram_board_destroy(witnesses[0]);
+        nonogram_board_destroy(witnesses[1]);
+        if (row < 0) {
+            return -1;
+        }
+        nonogram_board_set(board, row, col, NONOGRAM_FILLED);
+        blackened++;
+    }
+}
+
+// Function to report whether the hints have a single solution, printing where
+// two of them differ otherwise
+bool check_unique_solution(NonoGramHints *hints, int rows_count, int cols_count) {
+    NonoGramBoard *board = nonogram_board_create(rows_count, cols_count);
+    NonoGramBoard *witnesses[2] = {NULL, NULL};
+    int found = board != NULL ? nonogram_hints_count_solutions(hints, board, witnesses) : -1;
+    if (found < 0) {
+        fprintf(stderr, "Error: Memory allocation failed.\n");
+    } else if (found > 1) {
+        for (int i = 0; i < rows_count; i++) {
+            for (int j = 0; j < cols_count; j++) {
+                if (nonogram_board_get(witnesses[0], i, j) != nonogram_board_get(witnesses[1], i, j)) {
+                    fprintf(stderr, "Error: The puzzle has several solutions; two differ at row %d, column %d.\n",
+                            i + 1, j + 1);
+                    i = rows_count;
+                    break;
+                }
+            }
+        }
+    }
+    for (int k = 0; k < 2; k++) {
+        if (witnesses[k] != NULL) {
+            nonogram_board_destroy(witnesses[k]);
+        }
+    }
+    if (board != NULL) {
+        nonogram_board_destroy(board);
+    }
+    return found == 1;
+}
+
+// Function to generate a JSON file containing the hints
+bool generate_hints_json(const char *hints_file, NonoGramHints *hints) {
+    FILE *file = fopen(hints_file, "w");
+    if (file == NULL) {
+        fprintf(stderr, "Error: Failed to open JSON hints file for writing.\n");
+        return false;
+    }
+    const char *json_str = nonogram_hints_to_string(hints);
+    if (json_str != NULL) {
+        fprintf(file, "%s\n", json_str);
+    } else {
+        fprintf(stderr, "Error: Failed to convert hints to JSON.\n");
+    }
+    fclose(file);
+    return json_str != NULL;
+}
+
+// Function to generate a binary file containing the hints, in the narrowest
+// format that fits, or in one used in place by the solver
+bool generate_hints_binary(const char *binary_file, NonoGramHints *hints, bool in_place) {
+    size_t size = nonogram_hints_pack(hints, in_place, NULL, 0);
+    unsigned char *data = (unsigned char *)malloc(size);
+    if (data == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed.\n");
+        return false;
+    }
+    nonogram_hints_pack(hints, in_place, data, size);
+    FILE *file = fopen(binary_file, "wb");
+    bool written = file != NULL && fwrite(data, 1, size, file) == size;
+    if (file != NULL && fclose(file) != 0) {
+        written = false;
+    }
+    if (!written) {
+        fprintf(stderr, "Error: Failed to write binary hints file.\n");
+    }
+    free(data);
+    return written;
+}
+
+// Function to generate a PBM file with the cells blackened on the board
+bool generate_board_pbm(const char *board_file, NonoGramBoard *board) {
+    FILE *file = fopen(board_file, "w");
+    if (file == NULL) {
+        fprintf(stderr, "Error: Failed to open PBM board file for writing.\n");
+        return false;
+    }
+    int rows_count = nonogram_board_get_rows_count(board);
+    int cols_count = nonogram_board_get_cols_count(board);
+
+    // Write PBM header
+    fprintf(file, "P1\n%d %d\n", cols_count, rows_count);
+
+    // Write board data to the PBM file
+    for (int i = 0; i < rows_count; i++) {
+        for (int j = 0; j < cols_count; j++) {
+            fprintf(file, "%d ", nonogram_board_get(board, i, j) == NONOGRAM_FILLED);
+        }
+        fprintf(file, "\n");
+    }
+
+    fclose(file);
+    return true;
+}
+
+// Function to generate an SVG file representing the puzzle
+bool generate_svg(const char *output_file, const Image *image) {
+    FILE *file;
+
+    // Open the output file for writing or use stdout if output_file is NULL
+    if (output_file != NULL) {
+        file = fopen(output_file, "w");
+        if (file == NULL) {
+            fprintf(stderr, "Error: Failed to open output file for writing.\n");
+            return false;
+        }
+    } else {
+        file = stdout;
+    }
+
+    // Write the SVG header
+    if (output_file != NULL) {
+        fprintf(file, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+        fprintf(file, "<!DOCTYPE svg PUBLIC \"-//W3C//DTD SVG 1.1//EN\" \"http://www.w3.org/Graphics/SVG/1.1/DTD/svg11.dtd\">\n");
+    }
+    fprintf(file, "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%d\" height=\"%d\" version=\"1.1\">\n",
+            image->cols_count * 20, image->rows_count * 20);
+
+    // Loop through the image rows to generate SVG rectangles
+    for (int i = 0; i < image->rows_count; i++) {
+        for (int j = 0; j < image->cols_count; j++) {
+            fprintf(file, "<rect x=\"%d\" y=\"%d\" width=\"20\" height=\"20\" fill=\"%s\" stroke=\"black\"/>\n",
+                    j * 20, i * 20, is_black(image, i, j) ? "black" : "white");
+        }
+    }
+
+    // Write the SVG footer
+    fprintf(file, "</svg>\n");
+
+    // Close the output file if it's not stdout
+    if (output_file != NULL) {
+        fclose(file);
+    }
+    return true;
+}
+
+// Function to add the puzzle of an image to an archive: its hints, the image
+// as the solution and, with unique, the blackened cells as the initial board
+bool add_archive_puzzle(NonoGramArchiveWriter *writer, const char *image_file, bool unique) {
+    Image image;
+    if (!parse_pbm_image_libpnmio(image_file, &image)) {
+        fprintf(stderr, "%s: Error: Failed to parse PBM image.\n", image_file);
+        return false;
+    }
+    NonoGramHints *hints = calculate_hints(&image);
+    NonoGramBoard *solution = nonogram_board_create_from_bitmap(image.bits, image.rows_count, image.cols_count);
+    NonoGramBoard *board = NULL;
+    bool added = hints != NULL && solution != NULL;
+    if (added && unique) {
+        board = nonogram_board_create(image.rows_count, image.cols_count);
+        added = board != NULL && blacken_cells(hints, board, &image) >= 0;
+    }
+    if (added) {
+        added = nonogram_archive_writer_add(writer, hints, board, solution);
+    }
+    if (!added) {
+        fprintf(stderr, "%s: Error: Failed to add the puzzle to the archive.\n", image_file);
+    }
+    if (board != NULL) {
+        nonogram_board_destroy(board);
+    }
+    if (solution != NULL) {
+        nonogram_board_destroy(solution);
+    }
+    if (hints != NULL) {
+        nonogram_hints_destroy(hints);
+    }
+    free(image.bits);
+    return added;
+}
+
+// Function to write an archive holding the puzzles of several images
+bool generate_archive(const char *archive_file, char **image_files, int image_files_count, bool unique,
+                      bool in_place) {
+    FILE *file = fopen(archive_file, "wb");
+    if (file == NULL) {
+        fprintf(stderr, "Error: Failed to open archive file for writing.\n");
+        return false;
+    }
+    NonoGramArchiveWriter *writer = nonogram_archive_writer_create(file, in_place);
+    bool success = writer != NULL;
+    if (writer == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed.\n");
+    }
+    for (int i = 0; success && i < image_files_count; i++) {
+        success = add_archive_puzzle(writer, image_files[i], unique);
+    }
+    if (writer != NULL && !nonogram_archive_writer_close(writer) && success) {
+        fprintf(stderr, "Error: Failed to write archive file.\n");
+        success = false;
+    }
+    if (fclose(file) != 0) {
+        success = false;
+    }
+    return success;
+}
+
+void print_usage(const char *program_name) {
+    printf("Usage: %s <image_file> [--hints <hints_file>] [--binary <binary_file> [--in-place]] "
+           "[--board <board_file>] [--output <svg_file>] [--unique]\n",
+           program_name);
+    printf("       %s <image_file>... --archive <archive_file> [--in-place] [--unique]\n", program_name);
+}
+
+int main(int argc, char *argv[]) {
+    // Check the number of arguments
+    if (argc < 2) {
+        fprintf(stderr, "Error: Not enough arguments.\n");
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    // Parse command-line arguments
+    char **image_files = (char **)malloc(argc * sizeof(char *));
+    int image_files_count = 0;
+    const char *archive_file = NULL;
+    const char *hints_file = NULL;
+    const char *binary_file = NULL;
+    const char *board_file = NULL;
+    const char *output_file = NULL;
+    bool unique = false;
+    bool in_place = false;
+    for (int i = 1; i < argc; i++) {
+        const char **value = NULL;
+        if (strcmp(argv[i], "--hints") == 0) {
+            value = &hints_file;
+        } else if (strcmp(argv[i], "--binary") == 0) {
+            value = &binary_file;
+        } else if (strcmp(argv[i], "--archive") == 0) {
+            value = &archive_file;
+        } else if (strcmp(argv[i], "--board") == 0) {
+            value = &board_file;
+        } else if (strcmp(argv[i], "--output") == 0) {
+            value = &output_file;
+        } else if (strcmp(argv[i], "--unique") == 0) {
+            unique = true;
+            continue;
+        } else if (strcmp(argv[i], "--in-place") == 0) {
+            in_place = true;
+            continue;
+        } else if (argv[i][0] != '-' && image_files != NULL) {
+            image_files[image_files_count++] = argv[i];
+            continue;
+        } else {
+            fprintf(stderr, "Error: Unknown argument: %s\n", argv[i]);
+            print_usage(argv[0]);
+            free(image_files);
+            return 1;
+        }
+        if (i + 1 >= argc) {
+            fprintf(stderr, "Error: Missing argument for %s.\n", argv[i]);
+            print_usage(argv[0]);
+            free(image_files);
+            return 1;
+        }
+        *value = argv[++i];
+    }
+    if (image_files_count == 0) {
+        fprintf(stderr, "Error: Not enough arguments.\n");
+        print_usage(argv[0]);
+        free(image_files);
+        return 1;
+    }
+
+    // Archives take every image, and no output of a single one
+    if (archive_file != NULL || image_files_count > 1) {
+        bool valid = archive_file != NULL && hints_file == NULL && binary_file == NULL && board_file == NULL &&
+                     output_file == NULL;
+        if (!valid) {
+            fprintf(stderr, "Error: Several images go in an archive, with no other output.\n");
+            print_usage(argv[0]);
+        }
+        valid = valid && generate_archive(archive_file, image_files, image_files_count, unique, in_place);
+        free(image_files);
+        return valid ? 0 : 1;
+    }
+    const char *image_file = image_files[0];
+    free(image_files);
+
+    // Read the PBM image file once; every output comes from this copy
+    Image image;
+    if (!parse_pbm_image_libpnmio(image_file, &image)) {
+        fprintf(stderr, "Error: Failed to parse PBM image.\n");
+        return 1;
+    }
+
+    // Calculate hints from the image data
+    NonoGramHints *hints = calculate_hints(&image);
+    if (hints == NULL) {
+        free(image.bits);
+        return 1;
+    }
+
+    // Reject puzzles with several solutions before writing anything, unless
+    // the board is there to tell them apart
+    bool success = true;
+    if (unique && board_file == NULL) {
+        success = check_unique_solution(hints, image.rows_count, image.cols_count);
+    }
+
+    // Optionally, generate a JSON file containing the hints
+    if (success && hints_file != NULL) {
+        success = generate_hints_json(hints_file, hints);
+    }
+
+    // Optionally, generate a binary file containing the hints, with int
+    // tables that the solver maps in place if asked to
+    if (success && binary_file != NULL) {
+        success = generate_hints_binary(binary_file, hints, in_place);
+    }
+
+    // Optionally, generate a PBM file adding some blackened cells, as many as
+    // it takes for the puzzle to have a single solution
+    if (success && board_file != NULL) {
+        NonoGramBoard *board = nonogram_board_create(image.rows_count, image.cols_count);
+        int blackened = board != NULL ? blacken_cells(hints, board, &image) : -1;
+        if (blackened < 0) {
+            fprintf(stderr, "Error: Failed to make the solution unique.\n");
+            success = false;
+        } else {
+            success = generate_board_pbm(board_file, board);
+        }
+        if (board != NULL) {
+            nonogram_board_destroy(board);
+        }
+    }
+
+    // Generate an SVG file representing the puzzle
+    if (success) {
+        success = generate_svg(output_file, &image);
+    }
+
+    // Free the memory used by the image data and hints
+    nonogram_hints_to_string(NULL);
+    nonogram_hints_destroy(hints);
+    free(image.bits);
+
+    return success ? 0 : 1;
+}
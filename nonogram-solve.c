@@ -1,427 +1,1138 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include <stdbool.h>
-#include <string.h>
-#include "cJSON.h"
-#include "pnmio.h"
-
-// Structure to represent Nonogram hints
-typedef struct {
-    int **rows;
-    int **cols;
-    int rows_count;
-    int cols_count;
-} NonoGramHints;
-
-// Function to parse JSON hints file
-NonoGramHints *parse_json_hints(const char *hints_file) {
-    FILE *file = fopen(hints_file, "r");
-    if (file == NULL) {
-        fprintf(stderr, "Error: Failed to open JSON hints file.\n");
-        return NULL;
-    }
-
-    // Read JSON file content
-    fseek(file, 0, SEEK_END);
-    long file_size = ftell(file);
-    fseek(file, 0, SEEK_SET);
-    char *json_content = (char *)malloc(file_size + 1);
-    if (json_content == NULL) {
-        fprintf(stderr, "Error: Memory allocation failed.\n");
-        fclose(file);
-        return NULL;
-    }
-    fread(json_content, 1, file_size, file);
-    json_content[file_size] = '\0';
-
-    // Parse JSON content
-    cJSON *json = cJSON_Parse(json_content);
-    free(json_content);
-    fclose(file);
-
-    if (json == NULL) {
-        fprintf(stderr, "Error: Failed to parse JSON hints.\n");
-        return NULL;
-    }
-
-    // Extract hints for rows
-    cJSON *rows_array = cJSON_GetObjectItem(json, "rows");
-    if (rows_array == NULL || !cJSON_IsArray(rows_array)) {
-        cJSON_Delete(json);
-        fprintf(stderr, "Error: Invalid JSON hints format (rows).\n");
-        return NULL;
-    }
-    int rows_count = cJSON_GetArraySize(rows_array);
-    int **rows_hints = (int **)malloc(rows_count * sizeof(int *));
-    if (rows_hints == NULL) {
-        cJSON_Delete(json);
-        fprintf(stderr, "Error: Memory allocation failed.\n");
-        return NULL;
-    }
-    for (int i = 0; i < rows_count; i++) {
-        cJSON *row = cJSON_GetArrayItem(rows_array, i);
-        if (row == NULL || !cJSON_IsArray(row)) {
-            cJSON_Delete(json);
-            fprintf(stderr, "Error: Invalid JSON hints format (rows).\n");
-            return NULL;
-        }
-        int hints_count = cJSON_GetArraySize(row);
-        rows_hints[i] = (int *)malloc((hints_count + 1) * sizeof(int)); // Extra space for the terminating zero
-        if (rows_hints[i] == NULL) {
-            cJSON_Delete(json);
-            fprintf(stderr, "Error: Memory allocation failed.\n");
-            return NULL;
-        }
-        for (int j = 0; j < hints_count; j++) {
-            cJSON *hint = cJSON_GetArrayItem(row, j);
-            if (hint == NULL || !cJSON_IsNumber(hint)) {
-                cJSON_Delete(json);
-                fprintf(stderr, "Error: Invalid JSON hints format (rows).\n");
-                return NULL;
-            }
-            rows_hints[i][j] = hint->valueint;
-        }
-        rows_hints[i][hints_count] = 0; // Terminate with zero
-    }
-
-    // Extract hints for columns
-    cJSON *cols_array = cJSON_GetObjectItem(json, "cols");
-    if (cols_array == NULL || !cJSON_IsArray(cols_array)) {
-        cJSON_Delete(json);
-        fprintf(stderr, "Error: Invalid JSON hints format (cols).\n");
-        return NULL;
-    }
-    int cols_count = cJSON_GetArraySize(cols_array);
-    int **cols_hints = (int **)malloc(cols_count * sizeof(int *));
-    if (cols_hints == NULL) {
-        cJSON_Delete(json);
-        fprintf(stderr, "Error: Memory allocation failed.\n");
-        return NULL;
-    }
-    for (int i = 0; i < cols_count; i++) {
-        cJSON *col = cJSON_GetArrayItem(cols_array, i);
-        if (col == NULL || !cJSON_IsArray(col)) {
-            cJSON_Delete(json);
-            fprintf(stderr, "Error: Invalid JSON hints format (cols).\n");
-            return NULL;
-        }
-        int hints_count = cJSON_GetArraySize(col);
-        cols_hints[i] = (int *)malloc((hints_count + 1) * sizeof(int)); // Extra space for the terminating zero
-        if (cols_hints[i] == NULL) {
-            cJSON_Delete(json);
-            fprintf(stderr, "Error: Memory allocation failed.\n");
-            return NULL;
-        }
-        for (int j = 0; j < hints_count; j++) {
-            cJSON *hint = cJSON_GetArrayItem(col, j);
-            if (hint == NULL || !cJSON_IsNumber(hint)) {
-                cJSON_Delete(json);
-                fprintf(stderr, "Error: Invalid JSON hints format (cols).\n");
-                return NULL;
-            }
-            cols_hints[i][j] = hint->valueint;
-        }
-        cols_hints[i][hints_count] = 0; // Terminate with zero
-    }
-
-    // Create and populate NonoGramHints structure
-    NonoGramHints *hints = (NonoGramHints *)malloc(sizeof(NonoGramHints));
-    if (hints == NULL) {
-        cJSON_Delete(json);
-        fprintf(stderr, "Error: Memory allocation failed.\n");
-        return NULL;
-    }
-    hints->rows = rows_hints;
-    hints->cols = cols_hints;
-    hints->rows_count = rows_count;
-    hints->cols_count = cols_count;
-
-    cJSON_Delete(json);
-    return hints;
-}
-
-// Function to parse the initial board state from the PBM file using libpnmio
-int **parse_pbm_board_libpnmio(const char *board_file, int *rows_count, int *cols_count) {
-    FILE *file = fopen(board_file, "rb"); // Ouvrir le fichier en mode binaire
-    if (file == NULL) {
-        fprintf(stderr, "Error: Failed to open PBM board file.\n");
-        return NULL;
-    }
-
-    int img_type;
-    int is_ascii;
-    int xdim, ydim;
-    int **board = NULL;
-
-    // Lire l'en-tête PBM pour obtenir les dimensions et le type d'image
-    img_type = get_pnm_type(file);
-    if (img_type == PBM_BINARY || img_type == PBM_ASCII) {
-        if (read_pbm_header(file, &xdim, &ydim, &is_ascii) == FALSE) {
-            fprintf(stderr, "Error: Invalid PBM file format.\n");
-            fclose(file);
-            return NULL;
-        }
-    } else {
-        fprintf(stderr, "Error: Unsupported PBM image type.\n");
-        fclose(file);
-        return NULL;
-    }
-
-    // Allouer de la mémoire pour le tableau
-    board = (int **)malloc(ydim * sizeof(int *));
-    if (board == NULL) {
-        fprintf(stderr, "Error: Memory allocation failed.\n");
-        fclose(file);
-        return NULL;
-    }
-    for (int i = 0; i < ydim; i++) {
-        board[i] = (int *)malloc(xdim * sizeof(int));
-        if (board[i] == NULL) {
-            fprintf(stderr, "Error: Memory allocation failed.\n");
-            fclose(file);
-            for (int j = 0; j < i; j++) {
-                free(board[j]);
-            }
-            free(board);
-            return NULL;
-        }
-    }
-
-    // Lire les données de l'image PBM dans le tableau
-    if (img_type == PBM_BINARY) {
-        read_pbm_data(file, (int *)board, is_ascii);
-    } else if (img_type == PBM_ASCII) {
-        read_pbm_data(file, (int *)board, TRUE); // Toujours ASCII dans libpnmio
-    }
-
-    fclose(file);
-    *rows_count = ydim;
-    *cols_count = xdim;
-    return board;
-}
-// Function to check if the puzzle is solvable using simplistic reasoning
-bool is_puzzle_solvable(const NonoGramHints *hints, const int **initial_board) {
-    // Check rows
-    for (int i = 0; i < hints->rows_count; i++) {
-        int count = 0;
-        int hint_index = 0;
-        for (int j = 0; j < hints->cols_count; j++) {
-            if (initial_board[i][j] == 1) {
-                count++;
-            } else if (count > 0) {
-                if (hints->rows[i][hint_index] != count) {
-                    return false;
-                }
-                hint_index++;
-                count = 0;
-            }
-        }
-        if (count > 0 && hints->rows[i][hint_index] != count) {
-            return false;
-        }
-    }
-
-    // Check columns
-    for (int j = 0; j < hints->cols_count; j++) {
-        int count = 0;
-        int hint_index = 0;
-        for (int i = 0; i < hints->rows_count; i++) {
-            if (initial_board[i][j] == 1) {
-                count++;
-            } else if (count > 0) {
-                if (hints->cols[j][hint_index] != count) {
-                    return false;
-                }
-                hint_index++;
-                count = 0;
-            }
-        }
-        if (count > 0 && hints->cols[j][hint_index] != count) {
-            return false;
-        }
-    }
-
-    return true;
-}
-
-// Function to solve the nonogram puzzle
-void solve_nonogram(const char *hints_file, const char *board_file, const char *output_file) {
- // Parse JSON hints file
-    NonoGramHints *hints = parse_json_hints(hints_file);
-    if (hints == NULL) {
-        fprintf(stderr, "Error: Failed to parse JSON hints.\n");
-        return;
-    }
-
-    // Parse initial board state from PBM file if provided
-    int **initial_board = NULL;
-    int rows_count = 0, cols_count = 0; // Ajout des variables pour stocker les dimensions
-    if (board_file != NULL) {
-        initial_board = parse_pbm_board_libpnmio(board_file, &rows_count, &cols_count);
-        if (initial_board == NULL) {
-            fprintf(stderr, "Error: Failed to parse initial board state.\n");
-            return;
-        }
-    }
-
-    // Check if the puzzle is solvable using simplistic reasoning
-      if (!is_puzzle_solvable(hints, (const int **)initial_board)) {
-        fprintf(stderr, "Unsolvable puzzle.\n");
-        if (initial_board != NULL) {
-            for (int i = 0; i < rows_count; i++) {
-                free(initial_board[i]);
-            }
-            free(initial_board);
-        }
-        for (int i = 0; i < hints->rows_count; i++) {
-            free(hints->rows[i]);
-        }
-        for (int j = 0; j < hints->cols_count; j++) {
-            free(hints->cols[j]);
-        }
-        free(hints->rows);
-        free(hints->cols);
-        free(hints);
-        return;
-    }
-    // Implement algorithm to solve the nonogram puzzle based on hints and initial board state
-    // This could involve various logical deductions and backtracking
-    // For now, let's assume a simple approach of filling all cells as black if the hint is greater than 0
-
-    // Create the solved board
-    int **solved_board = (int **)malloc(hints->rows_count * sizeof(int *));
-    for (int i = 0; i < hints->rows_count; i++) {
-        solved_board[i] = (int *)malloc(hints->cols_count * sizeof(int));
-        memset(solved_board[i], 0, hints->cols_count * sizeof(int));
-    }
-
-    // Fill in the cells based on row hints
-    for (int i = 0; i < hints->rows_count; i++) {
-        int index = 0;
-        for (int j = 0; j < hints->cols_count; j++) {
-            if (hints->rows[i][index] > 0) {
-                solved_board[i][j] = 1;
-                hints->rows[i][index]--;
-            } else {
-                index++;
-                if (index >= hints->rows[i][0]) {
-                    break;
-                }
-            }
-        }
-    }
-
-    // Fill in the cells based on column hints
-    for (int j = 0; j < hints->cols_count; j++) {
-        int index = 0;
-        for (int i = 0; i < hints->rows_count; i++) {
-            if (hints->cols[j][index] > 0) {
-                solved_board[i][j] = 1;
-                hints->cols[j][index]--;
-            } else {
-                index++;
-                if (index >= hints->cols[j][0]) {
-                    break;
-                }
-            }
-        }
-    }
-
-    // Output the solution to the specified file or standard output
-    FILE *output = stdout;
-    if (output_file != NULL) {
-        output = fopen(output_file, "w");
-        if (output == NULL) {
-            fprintf(stderr, "Error: Failed to open output file for writing.\n");
-            return;
-        }
-    }
-
-    // Write PBM header
-    fprintf(output, "P1\n%d %d\n", hints->cols_count, hints->rows_count);
-
-    // Write solved board to output
-    for (int i = 0; i < hints->rows_count; i++) {
-        for (int j = 0; j < hints->cols_count; j++) {
-            fprintf(output, "%d ", solved_board[i][j]);
-        }
-        fprintf(output, "\n");
-    }
-
-    // Close output file if opened
-    if (output_file != NULL) {
-        fclose(output);
-    }
-
-    // Free memory
-    for (int i = 0; i < hints->rows_count; i++) {
-        free(solved_board[i]);
-    }
-    free(solved_board);
-
-    if (initial_board != NULL) {
-        for (int i = 0; i < hints->rows_count; i++) {
-            free(initial_board[i]);
-        }
-        free(initial_board);
-    }
-
-    for (int i = 0; i < hints->rows_count; i++) {
-        free(hints->rows[i]);
-    }
-    free(hints->rows);
-    for (int j = 0; j < hints->cols_count; j++) {
-        free(hints->cols[j]);
-    }
-    free(hints->cols);
-    free(hints);
-}
-
-void print_usage(const char *program_name) {
-    printf("Usage: %s <hints_file> [--board <board_file>] [--output <output_file>]\n", program_name);
-}
-
-int main(int argc, char *argv[]) {
-    // Check the number of arguments
-    if (argc < 2) {
-        fprintf(stderr, "Error: Not enough arguments.\n");
-        print_usage(argv[0]);
-        return 1;
-    }
-
-    // Parse command-line arguments
-    const char *hints_file = argv[1];
-    const char *board_file = NULL;
-    const char *output_file = NULL;
-
-    for (int i = 2; i < argc; i++) {
-        if (strcmp(argv[i], "--board") == 0) {
-            if (i + 1 < argc) {
-                board_file = argv[i + 1];
-                i++;
-            } else {
-                fprintf(stderr, "Error: Missing argument for --board.\n");
-                print_usage(argv[0]);
-                return 1;
-            }
-        } else if (strcmp(argv[i], "--output") == 0) {
-            if (i + 1 < argc) {
-                output_file = argv[i + 1];
-                i++;
-            } else {
-                fprintf(stderr, "Error: Missing argument for --output.\n");
-                print_usage(argv[0]);
-                return 1;
-            }
-        } else {
-            fprintf(stderr, "Error: Unknown argument: %s\n", argv[i]);
-            print_usage(argv[0]);
-            return 1;
-        }
-    }
-
-    // Solve the nonogram puzzle
-    solve_nonogram(hints_file, board_file, output_file);
-
-    return 0;
-}
+#include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "pnmio.h"
+#include "nonogram.h"
+
+// Function to parse JSON hints file
+NonoGramHints *parse_json_hints(const char *hints_file) {
+    FILE *file = fopen(hints_file, "r");
+    if (file == NULL) {
+        fprintf(stderr, "Error: Failed to open JSON hints file.\n");
+        return NULL;
+    }
+
+    // Tokenize the file straight into the hints, without a document tree
+    NonoGramHints *hints = nonogram_hints_read(file);
+    fclose(file);
+
+    if (hints == NULL) {
+        fprintf(stderr, "Error: Invalid JSON hints format.\n");
+        return NULL;
+    }
+    return hints;
+}
+
+// Function to tell binary hints files by their first bytes, so that only they
+// are mapped
+static bool is_binary_hints(const char *hints_file) {
+    FILE *file = fopen(hints_file, "rb");
+    if (file == NULL) {
+        return false;
+    }
+    char magic[4];
+    bool binary = fread(magic, 1, sizeof magic, file) == sizeof magic && memcmp(magic, "NGRM", sizeof magic) == 0;
+    fclose(file);
+    return binary;
+}
+
+// Function to load a hints file: binary hints are mapped, anything else is
+// parsed as JSON
+NonoGramHints *load_hints(const char *hints_file) {
+    if (!is_binary_hints(hints_file)) {
+        return parse_json_hints(hints_file);
+    }
+    NonoGramHints *hints = nonogram_hints_map(hints_file);
+    if (hints == NULL) {
+        fprintf(stderr, "Error: Invalid binary hints format.\n");
+    }
+    return hints;
+}
+
+// Function to tell hints files by their extension, returning its length or 0
+static size_t hints_extension(const char *name, size_t length) {
+    if (length > 5 && strcmp(name + length - 5, ".json") == 0) {
+        return 5;
+    }
+    if (length > 4 && strcmp(name + length - 4, ".ngb") == 0) {
+        return 4;
+    }
+    return 0;
+}
+
+// Function to parse the initial board state from the PBM file using libpnmio:
+// black cells are known filled, white cells are left unknown
+NonoGramBoard *parse_pbm_board_libpnmio(const char *board_file) {
+    FILE *file = fopen(board_file, "rb"); // Ouvrir le fichier en mode binaire
+    if (file == NULL) {
+        fprintf(stderr, "Error: Failed to open PBM board file.\n");
+        return NULL;
+    }
+
+    int img_type;
+    int is_ascii;
+    int xdim, ydim;
+
+    // Lire l'en-tête PBM pour obtenir les dimensions et le type d'image
+    img_type = get_pnm_type(file);
+    rewind(file);
+    if (img_type == PBM_BINARY || img_type == PBM_ASCII) {
+        if (read_pbm_header(file, &xdim, &ydim, &is_ascii) == FALSE) {
+            fprintf(stderr, "Error: Invalid PBM file format.\n");
+            fclose(file);
+            return NULL;
+        }
+    } else {
+        fprintf(stderr, "Error: Unsupported PBM image type.\n");
+        fclose(file);
+        return NULL;
+    }
+
+    // Read the raster in bulk as packed rows, padded to whole bytes
+    size_t stride = (xdim + 7) / 8;
+    unsigned char *bits = (unsigned char *)malloc(stride * ydim);
+    if (bits == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed.\n");
+        fclose(file);
+        return NULL;
+    }
+    if (read_pbm_bits(file, bits, xdim, ydim, is_ascii) == FALSE) {
+        fprintf(stderr, "Error: Truncated or invalid PBM data.\n");
+        free(bits);
+        fclose(file);
+        return NULL;
+    }
+    fclose(file);
+
+    // Unpack the rows directly into the bit-packed board
+    NonoGramBoard *board = nonogram_board_create_from_bitmap(bits, ydim, xdim);
+    free(bits);
+    if (board == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed.\n");
+        return NULL;
+    }
+    return board;
+}
+
+// Function to check if the puzzle is solvable using simplistic reasoning:
+// every row and column of the initial board must agree with its clues
+bool is_puzzle_solvable(NonoGramHints *hints, NonoGramBoard *initial_board) {
+    return initial_board == NULL || nonogram_hints_check(hints, initial_board);
+}
+
+// Per-worker solving context. Workers share nothing but the output lock, so
+// puzzles can be solved concurrently, one context per thread.
+typedef struct {
+    NonoGramPool *pool;    // Threads sharing the lines of one puzzle, or NULL
+    int jobs_count;        // Threads to create pool with once a puzzle needs it
+    NonoGramArena *arena;  // Memory of the puzzle being solved, or NULL
+    NonoGramCache *cache;  // Solutions of the puzzles solved before, or NULL
+    NonoGramMemo *memo;    // Line solves of the puzzles solved so far, or NULL
+    bool probe;            // Probe the cells line logic leaves unknown
+    bool stats;            // Report solver statistics of each puzzle on stderr
+    FILE *stream;          // In-memory stream collecting output bound for stdout
+    char *buffer;          // Contents of stream
+    size_t size;
+    const char *error;     // Why the last puzzle could not be solved
+    int solved;            // Number of puzzles solved with this context
+    int failed;            // Number of puzzles that could not be solved
+    int cached;            // Number of puzzles solved from the cache
+} SolveContext;
+
+// Function to create the memo table of a context: entries < 0 for the
+// default size, 0 for none
+static NonoGramMemo *create_memo(long entries) {
+    return entries != 0 ? nonogram_memo_create(entries > 0 ? (size_t)entries : 0) : NULL;
+}
+
+// Function to report why a puzzle could not be solved, prefixed with its
+// name when it is not NULL
+static bool fail_puzzle(SolveContext *context, const char *name, const char *message) {
+    fprintf(stderr, "%s%s%s\n", name != NULL ? name : "", name != NULL ? ": " : "", message);
+    context->error = message;
+    context->failed++;
+    return false;
+}
+
+// Function to write the solution of a puzzle as a PBM image, then release it
+// unless it is initial_board
+static bool write_puzzle(SolveContext *context, NonoGramBoard *solved_board, NonoGramBoard *initial_board,
+                         FILE *output, const char *name) {
+    int rows_count = nonogram_board_get_rows_count(solved_board);
+    int cols_count = nonogram_board_get_cols_count(solved_board);
+
+    // Write PBM header
+    fprintf(output, "P1\n");
+    if (name != NULL) {
+        fprintf(output, "# %s\n", name);
+    }
+    fprintf(output, "%d %d\n", cols_count, rows_count);
+
+    // Write solved board to output
+    for (int i = 0; i < rows_count; i++) {
+        for (int j = 0; j < cols_count; j++) {
+            fprintf(output, "%d ", nonogram_board_get(solved_board, i, j) == NONOGRAM_FILLED);
+        }
+        fprintf(output, "\n");
+    }
+
+    if (solved_board != initial_board) {
+        nonogram_board_destroy(solved_board);
+    }
+    context->solved++;
+    return true;
+}
+
+// Function to check that solution agrees with every known cell of board, if
+// any
+static bool board_extends(NonoGramBoard *solution, NonoGramBoard *board) {
+    if (board == NULL) {
+        return true;
+    }
+    for (int i = 0; i < nonogram_board_get_rows_count(board); i++) {
+        for (int j = 0; j < nonogram_board_get_cols_count(board); j++) {
+            int value = nonogram_board_get(board, i, j);
+            if (value != NONOGRAM_UNKNOWN && value != nonogram_board_get(solution, i, j)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Function to solve one puzzle and write its solution as a PBM image.
+// initial_board, if any, is used as the working board. name is written as a
+// PBM comment and prefixes error messages when it is not NULL.
+static bool solve_and_write_puzzle(SolveContext *context, NonoGramHints *hints, NonoGramBoard *initial_board,
+                                   FILE *output, const char *name) {
+    int rows_count = nonogram_hints_get_rows_count(hints);
+    int cols_count = nonogram_hints_get_cols_count(hints);
+    if (initial_board != NULL && (nonogram_board_get_rows_count(initial_board) != rows_count ||
+                                  nonogram_board_get_cols_count(initial_board) != cols_count)) {
+        return fail_puzzle(context, name, "Error: Board dimensions do not match the hints.");
+    }
+
+    // Check if the puzzle is solvable using simplistic reasoning
+    if (!is_puzzle_solvable(hints, initial_board)) {
+        return fail_puzzle(context, name, "Unsolvable puzzle.");
+    }
+
+    // A puzzle solved before, maybe rotated or mirrored, is taken from the
+    // cache, provided the solution extends the initial board
+    NonoGramBoard *solved_board = context->cache != NULL ? nonogram_cache_get(context->cache, hints) : NULL;
+    if (solved_board != NULL && !board_extends(solved_board, initial_board)) {
+        nonogram_board_destroy(solved_board);
+        solved_board = NULL;
+    }
+    if (solved_board != NULL) {
+        context->cached++;
+        return write_puzzle(context, solved_board, initial_board, output, name);
+    }
+
+    // The solved board starts from the initial board: its black cells are
+    // known, everything else is left to the line solver
+    solved_board = initial_board;
+    if (solved_board == NULL) {
+        solved_board = nonogram_board_create(rows_count, cols_count);
+        if (solved_board == NULL) {
+            return fail_puzzle(context, name, "Error: Memory allocation failed.");
+        }
+    }
+
+    // Propagate row and column deductions until nothing changes, optionally
+    // probe each unknown cell both ways, then search the cells that could not
+    // be deduced
+    const char *error = NULL;
+    int unknown = nonogram_hints_solve_parallel(hints, solved_board, context->pool);
+    if (unknown > 0 && context->probe) {
+        unknown = nonogram_hints_probe(hints, solved_board);
+    }
+    if (unknown < 0) {
+        error = unknown == -2 ? "Error: Memory allocation failed." : "Unsolvable puzzle.";
+    } else if (unknown > 0) {
+        int found = nonogram_hints_search(hints, solved_board);
+        if (found <= 0) {
+            error = found < 0 ? "Error: Memory allocation failed." : "Unsolvable puzzle.";
+        }
+    }
+    if (error != NULL) {
+        if (solved_board != initial_board) {
+            nonogram_board_destroy(solved_board);
+        }
+        return fail_puzzle(context, name, error);
+    }
+    if (context->cache != NULL) {
+        nonogram_cache_put(context->cache, hints, solved_board);
+    }
+    return write_puzzle(context, solved_board, initial_board, output, name);
+}
+
+// Function to write text as a JSON string, escaping what JSON requires, or
+// null if text is NULL
+static void write_json_string(FILE *output, const char *text) {
+    if (text == NULL) {
+        fputs("null", output);
+        return;
+    }
+    fputc('"', output);
+    for (const unsigned char *c = (const unsigned char *)text; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') {
+            fprintf(output, "\\%c", *c);
+        } else if (*c < 0x20) {
+            fprintf(output, "\\u%04x", *c);
+        } else {
+            fputc(*c, output);
+        }
+    }
+    fputc('"', output);
+}
+
+// Function to solve one puzzle as solve_and_write_puzzle does, reporting the
+// solver statistics as a JSON line on stderr if asked to
+bool solve_puzzle(SolveContext *context, NonoGramHints *hints, NonoGramBoard *initial_board, FILE *output,
+                  const char *name) {
+    // Lines already solved for this puzzle or earlier ones are looked up in
+    // the memo table of the context
+    NonoGramMemo *previous_memo = nonogram_memo_use(context->memo);
+    if (!context->stats) {
+        bool solved = solve_and_write_puzzle(context, hints, initial_board, output, name);
+        nonogram_memo_use(previous_memo);
+        return solved;
+    }
+    NonoGramStats stats;
+    memset(&stats, 0, sizeof stats);
+    NonoGramStats *previous = nonogram_stats_collect(&stats);
+    bool solved = solve_and_write_puzzle(context, hints, initial_board, output, name);
+    nonogram_stats_collect(previous);
+    nonogram_memo_use(previous_memo);
+    // The line is written in pieces: the lock keeps other workers out of it
+    flockfile(stderr);
+    fputs("{\"name\":", stderr);
+    write_json_string(stderr, name);
+    fprintf(stderr,
+            ",\"solved\":%s,\"line_solves\":%ld,\"cells_settled\":%ld,\"passes\":%ld,"
+            "\"probes\":%ld,\"search_nodes\":%ld,\"backtracks\":%ld,\"max_depth\":%d,\"memo_hits\":%ld,"
+            "\"solve_time\":%.6f,\"probe_time\":%.6f,\"search_time\":%.6f}\n",
+            solved ? "true" : "false", stats.line_solves, stats.cells_settled, stats.passes, stats.probes,
+            stats.search_nodes, stats.backtracks, stats.max_depth, stats.memo_hits, stats.solve_time,
+            stats.probe_time, stats.search_time);
+    funlockfile(stderr);
+    return solved;
+}
+
+// Function to solve the nonogram puzzle
+bool solve_nonogram(SolveContext *context, const char *hints_file, const char *board_file, const char *output_file) {
+ // Load the binary or JSON hints file
+    NonoGramHints *hints = load_hints(hints_file);
+    if (hints == NULL) {
+        fprintf(stderr, "Error: Failed to load hints.\n");
+        context->failed++;
+        return false;
+    }
+
+    // Threads are only started for boards large enough to spread their lines
+    // over them; without a pool, the puzzle is solved on this thread
+    if (context->pool == NULL && context->jobs_count > 1 &&
+        (long)nonogram_hints_get_rows_count(hints) * nonogram_hints_get_cols_count(hints) >=
+            NONOGRAM_PARALLEL_MIN_CELLS) {
+        context->pool = nonogram_pool_create(context->jobs_count);
+    }
+
+    // Parse initial board state from PBM file if provided
+    NonoGramBoard *initial_board = NULL;
+    if (board_file != NULL) {
+        initial_board = parse_pbm_board_libpnmio(board_file);
+        if (initial_board == NULL) {
+            fprintf(stderr, "Error: Failed to parse initial board state.\n");
+            nonogram_hints_destroy(hints);
+            context->failed++;
+            return false;
+        }
+    }
+
+    // Output the solution to the specified file or standard output
+    FILE *output = stdout;
+    if (output_file != NULL) {
+        output = fopen(output_file, "w");
+        if (output == NULL) {
+            fprintf(stderr, "Error: Failed to open output file for writing.\n");
+            if (initial_board != NULL) {
+                nonogram_board_destroy(initial_board);
+            }
+            nonogram_hints_destroy(hints);
+            context->failed++;
+            return false;
+        }
+    }
+
+    bool solved = solve_puzzle(context, hints, initial_board, output, NULL);
+
+    // Close output file if opened
+    if (output_file != NULL) {
+        fclose(output);
+    }
+
+    // Free memory
+    if (initial_board != NULL) {
+        nonogram_board_destroy(initial_board);
+    }
+    nonogram_hints_destroy(hints);
+    return solved;
+}
+
+// Batch shared by every worker: the puzzles to solve and where results go
+typedef struct {
+    const char *output_dir;       // Directory receiving <name>.pbm, or NULL for stdout
+    bool is_jsonl;                // Items are hint sets rather than hints file paths
+    NonoGramArchive *archive;     // Archive holding the puzzles instead of items, or NULL
+    char **items;                 // Hints file paths or JSON hint sets
+    int *lines;                   // Source line of each JSON hint set
+    int count;
+    int capacity;
+    bool probe;                   // Probe before searching
+    bool stats;                   // Report solver statistics
+    NonoGramCache *cache;         // Solutions of the puzzles solved before, or NULL
+    long memo_entries;            // Size of the memo table of each worker
+    SolveContext *contexts;       // One context per worker
+    pthread_mutex_t output_mutex; // Serializes writes to stdout
+} Batch;
+
+static bool add_batch_item(Batch *batch, char *item, int line) {
+    if (item == NULL) {
+        return false;
+    }
+    if (batch->count == batch->capacity) {
+        int capacity = batch->capacity ? 2 * batch->capacity : 256;
+        char **items = (char **)realloc(batch->items, capacity * sizeof(char *));
+        if (items == NULL) {
+            free(item);
+            return false;
+        }
+        batch->items = items;
+        int *lines = (int *)realloc(batch->lines, capacity * sizeof(int));
+        if (lines == NULL) {
+            free(item);
+            return false;
+        }
+        batch->lines = lines;
+        batch->capacity = capacity;
+    }
+    batch->items[batch->count] = item;
+    batch->lines[batch->count++] = line;
+    return true;
+}
+
+// Function to solve one puzzle of a batch with the context of a worker,
+// from its initial board if any
+static void solve_batch_puzzle(Batch *batch, SolveContext *context, NonoGramHints *hints, NonoGramBoard *board,
+                               const char *name) {
+    if (hints == NULL) {
+        fprintf(stderr, "%s: Error: Invalid hints format.\n", name);
+        context->failed++;
+        return;
+    }
+    if (batch->output_dir != NULL) {
+        char *path = (char *)malloc(strlen(batch->output_dir) + strlen(name) + 6);
+        FILE *output = NULL;
+        if (path != NULL) {
+            sprintf(path, "%s/%s.pbm", batch->output_dir, name);
+            output = fopen(path, "w");
+            free(path);
+        }
+        if (output == NULL) {
+            fprintf(stderr, "%s: Error: Failed to open output file for writing.\n", name);
+            context->failed++;
+        } else {
+            solve_puzzle(context, hints, board, output, name);
+            fclose(output);
+        }
+    } else if (context->stream != NULL) {
+        // Collect the solution in memory, then write it out in one piece
+        rewind(context->stream);
+        if (solve_puzzle(context, hints, board, context->stream, name)) {
+            fflush(context->stream);
+            pthread_mutex_lock(&batch->output_mutex);
+            fwrite(context->buffer, 1, context->size, stdout);
+            pthread_mutex_unlock(&batch->output_mutex);
+        }
+    } else {
+        fprintf(stderr, "%s: Error: Memory allocation failed.\n", name);
+        context->failed++;
+    }
+    nonogram_hints_destroy(hints);
+}
+
+// Function to solve item index of the batch
+static void solve_batch_item(Batch *batch, SolveContext *context, int index) {
+    if (batch->archive != NULL) {
+        char name[32];
+        snprintf(name, sizeof name, "puzzle-%d", index + 1);
+        NonoGramHints *hints = NULL;
+        NonoGramBoard *board = NULL;
+        nonogram_archive_get(batch->archive, index, &hints, &board, NULL);
+        solve_batch_puzzle(batch, context, hints, board, name);
+        if (board != NULL) {
+            nonogram_board_destroy(board);
+        }
+        return;
+    }
+    const char *item = batch->items[index];
+    if (batch->is_jsonl) {
+        char name[32];
+        snprintf(name, sizeof name, "line-%d", batch->lines[index]);
+        solve_batch_puzzle(batch, context, nonogram_hints_parse(item), NULL, name);
+        return;
+    }
+
+    // Hints files are named after their base name
+    const char *base = strrchr(item, '/');
+    base = base != NULL ? base + 1 : item;
+    size_t length = strlen(base);
+    length -= hints_extension(base, length);
+    char *name = strndup(base, length);
+    if (name == NULL) {
+        fprintf(stderr, "%s: Error: Memory allocation failed.\n", item);
+        context->failed++;
+        return;
+    }
+    // Binary hints are mapped, anything else is parsed as JSON, as load_hints
+    // does
+    if (is_binary_hints(item)) {
+        NonoGramHints *hints = nonogram_hints_map(item);
+        if (hints == NULL) {
+            fprintf(stderr, "%s: Error: Invalid binary hints format.\n", name);
+            context->failed++;
+        } else {
+            solve_batch_puzzle(batch, context, hints, NULL, name);
+        }
+        free(name);
+        return;
+    }
+    FILE *file = fopen(item, "r");
+    if (file == NULL) {
+        fprintf(stderr, "%s: Error: Failed to open hints file.\n", item);
+        context->failed++;
+    } else {
+        solve_batch_puzzle(batch, context, nonogram_hints_read(file), NULL, name);
+        fclose(file);
+    }
+    free(name);
+}
+
+// Task run by the workers: solve item index of the batch with everything the
+// puzzle needs in the arena of the worker, then give the arena back at once
+static void solve_batch_task(void *data, int index, int worker) {
+    Batch *batch = (Batch *)data;
+    SolveContext *context = &batch->contexts[worker];
+    NonoGramArena *previous = nonogram_arena_use(context->arena);
+    solve_batch_item(batch, context, index);
+    nonogram_arena_use(previous);
+    if (context->arena != NULL) {
+        nonogram_arena_reset(context->arena);
+    }
+}
+
+static int compare_strings(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+// Function to collect every *.json and *.ngb file of a directory, in name
+// order
+static bool collect_batch_directory(Batch *batch, const char *directory) {
+    DIR *dir = opendir(directory);
+    if (dir == NULL) {
+        fprintf(stderr, "Error: Failed to open batch directory.\n");
+        return false;
+    }
+    bool collected = true;
+    struct dirent *entry;
+    while (collected && (entry = readdir(dir)) != NULL) {
+        size_t length = strlen(entry->d_name);
+        if (hints_extension(entry->d_name, length) == 0) {
+            continue;
+        }
+        char *path = (char *)malloc(strlen(directory) + length + 2);
+        if (path != NULL) {
+            sprintf(path, "%s/%s", directory, entry->d_name);
+        }
+        collected = add_batch_item(batch, path, 0);
+    }
+    closedir(dir);
+    qsort(batch->items, batch->count, sizeof(char *), compare_strings);
+    return collected;
+}
+
+// Function to collect a stream that is either a manifest (one hints file
+// path per line) or JSON lines (one hint set per line), told apart by its
+// first non-blank character. Blank lines, and manifest lines starting with
+// '#', are skipped.
+static bool collect_batch_stream(Batch *batch, FILE *stream) {
+    char *line = NULL;
+    size_t size = 0;
+    ssize_t length;
+    int line_number = 0;
+    int is_jsonl = -1;
+    bool collected = true;
+    while (collected && (length = getline(&line, &size, stream)) != -1) {
+        line_number++;
+        while (length > 0 && isspace((unsigned char)line[length - 1])) {
+            line[--length] = '\0';
+        }
+        const char *start = line;
+        while (isspace((unsigned char)*start)) {
+            start++;
+        }
+        if (*start == '\0') {
+            continue;
+        }
+        if (is_jsonl == -1) {
+            is_jsonl = *start == '{';
+            batch->is_jsonl = is_jsonl;
+        }
+        if (is_jsonl || *start != '#') {
+            collected = add_batch_item(batch, strdup(start), line_number);
+        }
+    }
+    free(line);
+    return collected;
+}
+
+// Function to report how many puzzles were solved, and how many of them came
+// from the cache if there is one
+static void report_solved(NonoGramCache *cache, int solved, int failed, int cached) {
+    if (cache != NULL) {
+        fprintf(stderr, "Solved %d of %d puzzles, %d from the cache.\n", solved, solved + failed, cached);
+    } else {
+        fprintf(stderr, "Solved %d of %d puzzles.\n", solved, solved + failed);
+    }
+}
+
+// Function to solve every puzzle of a batch on jobs_count threads
+static bool run_batch(Batch *batch, int jobs_count) {
+    NonoGramPool *pool = nonogram_pool_create(jobs_count);
+    if (pool == NULL) {
+        fprintf(stderr, "Error: Failed to start worker threads.\n");
+        return false;
+    }
+    int workers_count = nonogram_pool_get_workers_count(pool);
+    batch->contexts = (SolveContext *)calloc(workers_count, sizeof(SolveContext));
+    if (batch->contexts == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed.\n");
+        nonogram_pool_destroy(pool);
+        return false;
+    }
+    for (int worker = 0; worker < workers_count; worker++) {
+        SolveContext *context = &batch->contexts[worker];
+        context->probe = batch->probe;
+        context->stats = batch->stats;
+        context->cache = batch->cache;
+        context->stream = open_memstream(&context->buffer, &context->size);
+        // Without an arena, the worker falls back on malloc
+        context->arena = nonogram_arena_create(0);
+        context->memo = create_memo(batch->memo_entries);
+    }
+    pthread_mutex_init(&batch->output_mutex, NULL);
+
+    int count = batch->archive != NULL ? nonogram_archive_get_count(batch->archive) : batch->count;
+    nonogram_pool_run(pool, count, solve_batch_task, batch);
+
+    int solved = 0, failed = 0, cached = 0;
+    for (int worker = 0; worker < workers_count; worker++) {
+        SolveContext *context = &batch->contexts[worker];
+        if (context->stream != NULL) {
+            fclose(context->stream);
+            free(context->buffer);
+        }
+        if (context->arena != NULL) {
+            nonogram_arena_destroy(context->arena);
+        }
+        if (context->memo != NULL) {
+            nonogram_memo_destroy(context->memo);
+        }
+        solved += context->solved;
+        failed += context->failed;
+        cached += context->cached;
+    }
+    pthread_mutex_destroy(&batch->output_mutex);
+    free(batch->contexts);
+    nonogram_pool_destroy(pool);
+    report_solved(batch->cache, solved, failed, cached);
+    return failed == 0;
+}
+
+// Function to solve every puzzle of a directory, archive, manifest or
+// JSON-lines source ("-" reads standard input), or of a list of hints files,
+// in a single process
+bool solve_batch(const char *source, char **files, int files_count, const char *output_dir, int jobs_count,
+                 bool probe, bool stats, NonoGramCache *cache, long memo_entries) {
+    Batch batch;
+    memset(&batch, 0, sizeof batch);
+    batch.output_dir = output_dir;
+    batch.probe = probe;
+    batch.stats = stats;
+    batch.cache = cache;
+    batch.memo_entries = memo_entries;
+    bool collected = true;
+    struct stat info;
+    if (source == NULL) {
+        for (int i = 0; i < files_count && collected; i++) {
+            collected = add_batch_item(&batch, strdup(files[i]), 0);
+        }
+    } else if (strcmp(source, "-") == 0) {
+        collected = collect_batch_stream(&batch, stdin);
+    } else if (stat(source, &info) == 0 && S_ISDIR(info.st_mode)) {
+        collected = collect_batch_directory(&batch, source);
+    } else if ((batch.archive = nonogram_archive_open(source)) != NULL) {
+        // Puzzles are read from the mapped archive by index
+    } else {
+        FILE *stream = fopen(source, "r");
+        if (stream == NULL) {
+            fprintf(stderr, "Error: Failed to open batch source.\n");
+            return false;
+        }
+        collected = collect_batch_stream(&batch, stream);
+        fclose(stream);
+    }
+
+    bool solved = false;
+    if (collected) {
+        solved = run_batch(&batch, jobs_count);
+    } else {
+        fprintf(stderr, "Error: Failed to read the batch.\n");
+    }
+    for (int i = 0; i < batch.count; i++) {
+        free(batch.items[i]);
+    }
+    free(batch.items);
+    free(batch.lines);
+    if (batch.archive != NULL) {
+        nonogram_archive_close(batch.archive);
+    }
+    return solved;
+}
+
+// Server listening on a Unix domain socket. Each worker thread accepts
+// connections in turn and keeps its context, arena included, from one
+// puzzle to the next. Clients send one JSON hint set per line and get back,
+// for each line, the PBM image of the solution or a single "error: " line.
+typedef struct {
+    int listener;                 // Listening socket
+    SolveContext *contexts;       // One context per worker
+    int *clients;                 // Connection served by each worker, or -1
+    pthread_mutex_t mutex;        // Guards clients and stopping
+    bool stopping;
+} Server;
+
+typedef struct {
+    Server *server;
+    int worker;
+} ServerWorker;
+
+// Function to answer the requests of one connection until the client
+// closes it
+static void serve_client(SolveContext *context, int client) {
+    FILE *input = fdopen(client, "r");
+    int output_fd = dup(client);
+    FILE *output = output_fd >= 0 ? fdopen(output_fd, "w") : NULL;
+    if (input == NULL || output == NULL) {
+        if (output == NULL && output_fd >= 0) {
+            close(output_fd);
+        }
+        if (input != NULL) {
+            fclose(input);
+        } else {
+            close(client);
+        }
+        return;
+    }
+    char *line = NULL;
+    size_t size = 0;
+    ssize_t length;
+    bool connected = true;
+    while (connected && (length = getline(&line, &size, input)) != -1) {
+        while (length > 0 && isspace((unsigned char)line[length - 1])) {
+            line[--length] = '\0';
+        }
+        if (length == 0) {
+            continue;
+        }
+        // Everything the request needs comes from the arena of the worker. The
+        // parser rejects clues that do not fit in their lines, so that hints
+        // sent by a client are safe to solve.
+        NonoGramArena *previous = nonogram_arena_use(context->arena);
+        NonoGramHints *hints = nonogram_hints_parse(line);
+        bool solved = false;
+        if (hints == NULL) {
+            fail_puzzle(context, NULL, "Error: Invalid hints format.");
+        } else if (context->stream == NULL) {
+            fail_puzzle(context, NULL, "Error: Memory allocation failed.");
+        } else {
+            rewind(context->stream);
+            solved = solve_puzzle(context, hints, NULL, context->stream, NULL);
+            fflush(context->stream);
+        }
+        if (hints != NULL) {
+            nonogram_hints_destroy(hints);
+        }
+        nonogram_arena_use(previous);
+        if (context->arena != NULL) {
+            nonogram_arena_reset(context->arena);
+        }
+
+        if (solved) {
+            fwrite(context->buffer, 1, context->size, output);
+        } else {
+            const char *error = context->error;
+            if (strncmp(error, "Error: ", 7) == 0) {
+                error += 7;
+            }
+            fprintf(output, "error: %s\n", error);
+        }
+        connected = fflush(output) == 0;
+    }
+    free(line);
+    fclose(output);
+    fclose(input);
+}
+
+// Thread of a server worker: accept connections until the server stops
+static void *serve_connections(void *data) {
+    ServerWorker *self = (ServerWorker *)data;
+    Server *server = self->server;
+    SolveContext *context = &server->contexts[self->worker];
+    while (true) {
+        int client = accept(server->listener, NULL, NULL);
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            break;
+        }
+        pthread_mutex_lock(&server->mutex);
+        bool stopping = server->stopping;
+        if (!stopping) {
+            server->clients[self->worker] = client;
+        }
+        pthread_mutex_unlock(&server->mutex);
+        if (stopping) {
+            close(client);
+            break;
+        }
+        serve_client(context, client);
+        pthread_mutex_lock(&server->mutex);
+        server->clients[self->worker] = -1;
+        pthread_mutex_unlock(&server->mutex);
+    }
+    return NULL;
+}
+
+// Function to serve puzzles on the socket at path with jobs_count workers,
+// until SIGINT or SIGTERM
+bool serve(const char *path, int jobs_count, bool probe, bool stats, NonoGramCache *cache, long memo_entries) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof address);
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof address.sun_path) {
+        fprintf(stderr, "Error: Socket path too long.\n");
+        return false;
+    }
+    strcpy(address.sun_path, path);
+
+    // A socket left behind by an earlier server is replaced, nothing else
+    struct stat info;
+    if (stat(path, &info) == 0 && S_ISSOCK(info.st_mode)) {
+        unlink(path);
+    }
+    Server server;
+    memset(&server, 0, sizeof server);
+    server.listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server.listener < 0 || bind(server.listener, (struct sockaddr *)&address, sizeof address) != 0 ||
+        listen(server.listener, 64) != 0) {
+        fprintf(stderr, "Error: Failed to listen on %s: %s\n", path, strerror(errno));
+        if (server.listener >= 0) {
+            close(server.listener);
+        }
+        return false;
+    }
+
+    // Signals are taken by sigwait below, not by the workers; clients that
+    // leave early are noticed by write errors
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    server.contexts = (SolveContext *)calloc(jobs_count, sizeof(SolveContext));
+    server.clients = (int *)malloc(jobs_count * sizeof(int));
+    pthread_t *threads = (pthread_t *)malloc(jobs_count * sizeof(pthread_t));
+    ServerWorker *workers = (ServerWorker *)malloc(jobs_count * sizeof(ServerWorker));
+    int started = 0;
+    if (server.contexts != NULL && server.clients != NULL && threads != NULL && workers != NULL) {
+        pthread_mutex_init(&server.mutex, NULL);
+        for (int worker = 0; worker < jobs_count; worker++) {
+            SolveContext *context = &server.contexts[worker];
+            context->probe = probe;
+            context->stats = stats;
+            context->cache = cache;
+            context->stream = open_memstream(&context->buffer, &context->size);
+            context->arena = nonogram_arena_create(0);
+            context->memo = create_memo(memo_entries);
+            server.clients[worker] = -1;
+            workers[worker].server = &server;
+            workers[worker].worker = worker;
+        }
+        while (started < jobs_count &&
+               pthread_create(&threads[started], NULL, serve_connections, &workers[started]) == 0) {
+            started++;
+        }
+    }
+    if (started > 0) {
+        fprintf(stderr, "Listening on %s with %d workers.\n", path, started);
+        int signal_number;
+        sigwait(&signals, &signal_number);
+
+        // Wake the workers out of accept and out of the connections they serve
+        pthread_mutex_lock(&server.mutex);
+        server.stopping = true;
+        shutdown(server.listener, SHUT_RDWR);
+        for (int worker = 0; worker < jobs_count; worker++) {
+            if (server.clients[worker] >= 0) {
+                shutdown(server.clients[worker], SHUT_RD);
+            }
+        }
+        pthread_mutex_unlock(&server.mutex);
+        for (int worker = 0; worker < started; worker++) {
+            pthread_join(threads[worker], NULL);
+        }
+    } else {
+        fprintf(stderr, "Error: Failed to start worker threads.\n");
+    }
+
+    int solved = 0, failed = 0, cached = 0;
+    for (int worker = 0; server.contexts != NULL && worker < jobs_count; worker++) {
+        SolveContext *context = &server.contexts[worker];
+        if (context->stream != NULL) {
+            fclose(context->stream);
+            free(context->buffer);
+        }
+        if (context->arena != NULL) {
+            nonogram_arena_destroy(context->arena);
+        }
+        if (context->memo != NULL) {
+            nonogram_memo_destroy(context->memo);
+        }
+        solved += context->solved;
+        failed += context->failed;
+        cached += context->cached;
+    }
+    if (server.contexts != NULL && server.clients != NULL && threads != NULL && workers != NULL) {
+        pthread_mutex_destroy(&server.mutex);
+    }
+    close(server.listener);
+    unlink(path);
+    free(server.contexts);
+    free(server.clients);
+    free(threads);
+    free(workers);
+    if (started > 0) {
+        report_solved(cache, solved, failed, cached);
+    }
+    return started > 0;
+}
+
+void print_usage(const char *program_name) {
+    printf("Usage: %s <hints_file> [--board <board_file>] [--output <output_file>] [--probe] [--stats]\n"
+           "       [--cache <directory>] [--memo <entries>]\n",
+           program_name);
+    printf("       %s <hints_file>... [--jobs <count>] [--output <output_directory>] [--probe] [--stats]\n"
+           "       [--cache <directory>] [--memo <entries>]\n",
+           program_name);
+    printf("       %s --batch <directory|archive|manifest|jsonl|-> [--jobs <count>] [--output <output_directory>] "
+           "[--probe] [--stats]\n"
+           "       [--cache <directory>] [--memo <entries>]\n",
+           program_name);
+    printf("       %s --serve <socket> [--jobs <count>] [--probe] [--stats] [--cache <directory>]\n"
+           "       [--memo <entries>]\n",
+           program_name);
+}
+
+int main(int argc, char *argv[]) {
+    // Check the number of arguments
+    if (argc < 2) {
+        fprintf(stderr, "Error: Not enough arguments.\n");
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    // Parse command-line arguments
+    char **hints_files = (char **)malloc(argc * sizeof(char *));
+    int hints_files_count = 0;
+    const char *board_file = NULL;
+    const char *output_file = NULL;
+    const char *batch_source = NULL;
+    const char *socket_path = NULL;
+    const char *cache_path = NULL;
+    long memo_entries = -1;
+    long jobs_count = sysconf(_SC_NPROCESSORS_ONLN);
+    bool probe = false;
+    bool stats = false;
+    if (hints_files == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed.\n");
+        return 1;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--board") == 0) {
+            if (i + 1 < argc) {
+                board_file = argv[i + 1];
+                i++;
+            } else {
+                fprintf(stderr, "Error: Missing argument for --board.\n");
+                print_usage(argv[0]);
+                free(hints_files);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--output") == 0) {
+            if (i + 1 < argc) {
+                output_file = argv[i + 1];
+                i++;
+            } else {
+                fprintf(stderr, "Error: Missing argument for --output.\n");
+                print_usage(argv[0]);
+                free(hints_files);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--batch") == 0) {
+            if (i + 1 < argc) {
+                batch_source = argv[i + 1];
+                i++;
+            } else {
+                fprintf(stderr, "Error: Missing argument for --batch.\n");
+                print_usage(argv[0]);
+                free(hints_files);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--serve") == 0) {
+            if (i + 1 < argc) {
+                socket_path = argv[i + 1];
+                i++;
+            } else {
+                fprintf(stderr, "Error: Missing argument for --serve.\n");
+                print_usage(argv[0]);
+                free(hints_files);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--cache") == 0) {
+            if (i + 1 < argc) {
+                cache_path = argv[i + 1];
+                i++;
+            } else {
+                fprintf(stderr, "Error: Missing argument for --cache.\n");
+                print_usage(argv[0]);
+                free(hints_files);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--memo") == 0) {
+            char *end = NULL;
+            if (i + 1 < argc && (memo_entries = strtol(argv[i + 1], &end, 10)) >= 0 && *end == '\0') {
+                i++;
+            } else {
+                fprintf(stderr, "Error: Missing or invalid argument for --memo.\n");
+                print_usage(argv[0]);
+                free(hints_files);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--jobs") == 0) {
+            if (i + 1 < argc && (jobs_count = strtol(argv[i + 1], NULL, 10)) > 0) {
+                i++;
+            } else {
+                fprintf(stderr, "Error: Missing or invalid argument for --jobs.\n");
+                print_usage(argv[0]);
+                free(hints_files);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--probe") == 0) {
+            probe = true;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            stats = true;
+        } else if (argv[i][0] != '-' || argv[i][1] == '\0') {
+            hints_files[hints_files_count++] = argv[i];
+        } else {
+            fprintf(stderr, "Error: Unknown argument: %s\n", argv[i]);
+            print_usage(argv[0]);
+            free(hints_files);
+            return 1;
+        }
+    }
+    if (jobs_count < 1) {
+        jobs_count = 1;
+    }
+
+    // Solutions found are kept in the cache, where later runs look first
+    NonoGramCache *cache = NULL;
+    if (cache_path != NULL && (cache = nonogram_cache_open(cache_path)) == NULL) {
+        fprintf(stderr, "Error: Failed to open cache directory %s.\n", cache_path);
+        free(hints_files);
+        return 1;
+    }
+
+    int status;
+    if (socket_path != NULL) {
+        if (board_file != NULL || output_file != NULL || batch_source != NULL || hints_files_count > 0) {
+            fprintf(stderr, "Error: --serve takes no puzzle, --board, --output nor --batch.\n");
+            print_usage(argv[0]);
+            status = 1;
+        } else {
+            // Answer clients until interrupted
+            status = serve(socket_path, (int)jobs_count, probe, stats, cache, memo_entries) ? 0 : 1;
+        }
+    } else if (batch_source != NULL || hints_files_count > 1) {
+        if (board_file != NULL || (batch_source != NULL && hints_files_count > 0)) {
+            fprintf(stderr, "Error: Batches take neither --board nor both --batch and hints files.\n");
+            print_usage(argv[0]);
+            status = 1;
+        } else {
+            // Solve every puzzle of the batch; --output names a directory
+            status = solve_batch(batch_source, hints_files, hints_files_count, output_file, (int)jobs_count,
+                                 probe, stats, cache, memo_entries) ? 0 : 1;
+        }
+    } else if (hints_files_count == 1) {
+        // Solve the nonogram puzzle, spreading its lines over the threads
+        SolveContext context;
+        memset(&context, 0, sizeof context);
+        context.probe = probe;
+        context.stats = stats;
+        context.cache = cache;
+        context.memo = create_memo(memo_entries);
+        context.jobs_count = (int)jobs_count;
+        status = solve_nonogram(&context, hints_files[0], board_file, output_file) ? 0 : 1;
+        if (context.pool != NULL) {
+            nonogram_pool_destroy(context.pool);
+        }
+        if (context.memo != NULL) {
+            nonogram_memo_destroy(context.memo);
+        }
+    } else {
+        fprintf(stderr, "Error: Not enough arguments.\n");
+        print_usage(argv[0]);
+        status = 1;
+    }
+
+    if (cache != NULL) {
+        nonogram_cache_close(cache);
+    }
+    free(hints_files);
+    return status;
+}
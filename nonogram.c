@@ -2,126 +2,933 @@
 #include "./nonogram.h"
 
 #include <assert.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <time.h>
 
 #include "./nonogram.inc"
 
-static NonoGramHints *_nonogram_hints_new(int rows_count, int cols_count) {
+NonoGramHints *_nonogram_hints_new(
+  int rows_count,
+  int cols_count,
+  int clues_count
+) {
   if (!rows_count || !cols_count) {
     return NULL;
   }
-  NonoGramHints *hints = malloc(sizeof(NonoGramHints));
+  int lines_count = rows_count + cols_count;
+  NonoGramHints *hints = _nonogram_alloc(
+    sizeof(NonoGramHints) + (lines_count + 1 + clues_count) * sizeof(int)
+  );
   if (!hints) {
     return NULL;
   }
-  hints->rows = malloc(rows_count * sizeof(int *));
-  if (!hints->rows) {
-    free(hints);
+  hints->rows_count = rows_count;
+  hints->cols_count = cols_count;
+  hints->offsets = (int *)(hints + 1);
+  hints->clues = hints->offsets + lines_count + 1;
+  hints->offsets[0] = 0;
+  hints->mapped = NULL;
+  hints->mapped_size = 0;
+  return hints;
+}
+
+NonoGramHints *nonogram_hints_create(
+  int **board,
+  int rows_count,
+  int cols_count
+) {
+  if (!rows_count || !cols_count) {
     return NULL;
   }
-  hints->cols = malloc(cols_count * sizeof(int *));
-  if (!hints->cols) {
-
-    free(hints->rows);
-    free(hints);
+  NonoGramBoard *filled = nonogram_board_create(rows_count, cols_count);
+  if (!filled) {
     return NULL;
   }
   for (int row = 0; row < rows_count; row++) {
-    hints->rows[row] = calloc(cols_count, sizeof(int));
-    if (!hints->rows[row]) {
-      for (int i = 0; i < row; i++) {
-        free(hints->rows[i]);
-      }
-      free(hints->rows);
-      free(hints->cols);
-      free(hints);
-      return NULL;
+    _nonogram_pack_line(
+      board[row],
+      cols_count,
+      filled->filled + (size_t)row * filled->row_words
+    );
+  }
+  _nonogram_board_sync_columns(filled);
+  NonoGramHints *hints = nonogram_hints_create_from_board(filled);
+  nonogram_board_destroy(filled);
+  return hints;
+}
+
+NonoGramHints *nonogram_hints_create_from_board(NonoGramBoard *board) {
+  int lines_count = board->rows_count + board->cols_count;
+  int clues_count = 0;
+  for (int line = 0; line < lines_count; line++) {
+    clues_count += _nonogram_board_runs_count(
+      _NONOGRAM_BOARD_FILLED(board, line),
+      _NONOGRAM_BOARD_LENGTH(board, line)
+    );
+  }
+  NonoGramHints *hints = _nonogram_hints_new(
+    board->rows_count,
+    board->cols_count,
+    clues_count
+  );
+  if (!hints) {
+    return NULL;
+  }
+  for (int line = 0; line < lines_count; line++) {
+    hints->offsets[line + 1] = hints->offsets[line] + _nonogram_board_runs(
+      _NONOGRAM_BOARD_FILLED(board, line),
+      _NONOGRAM_BOARD_LENGTH(board, line),
+      hints->clues + hints->offsets[line]
+    );
+  }
+  return hints;
+}
+
+static bool _reserve(int **array, int *capacity, int needed) {
+  if (needed <= *capacity) {
+    return true;
+  }
+  int grown = 2 * *capacity > needed ? 2 * *capacity : needed;
+  int *resized = realloc(*array, grown * sizeof(int));
+  if (!resized) {
+    return false;
+  }
+  *array = resized;
+  *capacity = grown;
+  return true;
+}
+
+/*
+ * Single pass over the rows: row clues are read off each row as it is
+ * unpacked, and every 64 rows the block is transposed into a column-major
+ * copy, so that column clues are read off whole words like row clues.
+ */
+NonoGramHints *nonogram_hints_create_from_bitmap(
+  const unsigned char *bitmap,
+  int rows_count,
+  int cols_count
+) {
+  if (rows_count <= 0 || cols_count <= 0) {
+    return NULL;
+  }
+  int stride = (cols_count + 7) / 8;
+  int row_words = _NONOGRAM_WORDS(cols_count);
+  int col_words = _NONOGRAM_WORDS(rows_count);
+  uint64_t *block = _nonogram_alloc(
+    (size_t)_NONOGRAM_WORD_BITS * row_words * sizeof(uint64_t)
+  );
+  uint64_t *cols = _nonogram_alloc(
+    (size_t)cols_count * col_words * sizeof(uint64_t)
+  );
+  int *row_offsets = _nonogram_alloc((rows_count + 1) * sizeof(int));
+  int *row_clues = NULL;
+  int row_capacity = 0;
+  bool allocated = block && cols && row_offsets;
+  if (allocated) {
+    row_offsets[0] = 0;
+  }
+  for (int row = 0; allocated && row < rows_count; row++) {
+    int first = row - row % _NONOGRAM_WORD_BITS;
+    uint64_t *current = block + (size_t)(row - first) * row_words;
+    _nonogram_bitmap_row(bitmap + (size_t)row * stride, cols_count, current);
+    allocated = _reserve(
+      &row_clues, &row_capacity, row_offsets[row] + (cols_count + 1) / 2
+    );
+    if (!allocated) {
+      break;
+    }
+    row_offsets[row + 1] = row_offsets[row] + _nonogram_board_runs(
+      current, cols_count, row_clues + row_offsets[row]
+    );
+    if (row + 1 == rows_count || (row + 1) % _NONOGRAM_WORD_BITS == 0) {
+      _nonogram_transpose(
+        block,
+        row + 1 - first,
+        cols_count,
+        row_words,
+        cols + first / _NONOGRAM_WORD_BITS,
+        col_words
+      );
     }
   }
-  for (int col = 0; col < cols_count; col++) {
-    hints->cols[col] = calloc(rows_count, sizeof(int));
-    if (!hints->cols[col]) {
-      for (int i = 0; i < col; i++) {
-        free(hints->cols[i]);
-      }
-      for (int row = 0; row < rows_count; row++) {
-        free(hints->rows[row]);
-      }
-      free(hints->rows);
-      free(hints->cols);
-      free(hints);
-      return NULL;
+
+  int clues_count = allocated ? row_offsets[rows_count] : 0;
+  for (int col = 0; allocated && col < cols_count; col++) {
+    clues_count += _nonogram_board_runs_count(
+      cols + (size_t)col * col_words, rows_count
+    );
+  }
+  NonoGramHints *hints = allocated ? _nonogram_hints_new(
+    rows_count,
+    cols_count,
+    clues_count
+  ) : NULL;
+  if (hints) {
+    memcpy(hints->offsets, row_offsets, (rows_count + 1) * sizeof(int));
+    memcpy(hints->clues, row_clues, row_offsets[rows_count] * sizeof(int));
+    int *offsets = hints->offsets + rows_count;
+    for (int col = 0; col < cols_count; col++) {
+      offsets[col + 1] = offsets[col] + _nonogram_board_runs(
+        cols + (size_t)col * col_words, rows_count, hints->clues + offsets[col]
+      );
     }
   }
+
+  free(row_clues);
+  _nonogram_free(row_offsets);
+  _nonogram_free(cols);
+  _nonogram_free(block);
   return hints;
 }
 
-static NonoGramHints *_nonogram_hints_fill(
-  NonoGramHints *hints,
-  int **board,
+static int _clues_count(const int *clues, int max) {
+  int count = 0;
+  while (count < max && clues[count] > 0) {
+    count++;
+  }
+  return count;
+}
+
+NonoGramHints *nonogram_hints_create_from_clues(
+  int **rows,
+  int **cols,
   int rows_count,
   int cols_count
 ) {
-  hints->rows_count = rows_count;
-  hints->cols_count = cols_count;
+  int clues_count = 0;
   for (int row = 0; row < rows_count; row++) {
-    int count = 0;
-    int index = 0;
-    for (int col = 0; col < cols_count; col++) {
-      if (board[row][col] == 1) {
-        count++;
-      } else {
-        if (count > 0) {
-          hints->rows[row][index++] = count;
-          count = 0;
+    clues_count += _clues_count(rows[row], cols_count);
+  }
+  for (int col = 0; col < cols_count; col++) {
+    clues_count += _clues_count(cols[col], rows_count);
+  }
+  NonoGramHints *hints = _nonogram_hints_new(
+    rows_count,
+    cols_count,
+    clues_count
+  );
+  if (!hints) {
+    return NULL;
+  }
+  int *offsets = hints->offsets;
+  for (int row = 0; row < rows_count; row++) {
+    int count = _clues_count(rows[row], cols_count);
+    memcpy(hints->clues + offsets[row], rows[row], count * sizeof(int));
+    offsets[row + 1] = offsets[row] + count;
+  }
+  offsets += rows_count;
+  for (int col = 0; col < cols_count; col++) {
+    int count = _clues_count(cols[col], rows_count);
+    memcpy(hints->clues + offsets[col], cols[col], count * sizeof(int));
+    offsets[col + 1] = offsets[col] + count;
+  }
+  return hints;
+}
+
+bool _nonogram_line_fits(const int *clues, int clues_count, int length) {
+  int64_t needed = clues_count ? clues_count - 1 : 0;
+  for (int index = 0; index < clues_count && needed <= length; index++) {
+    needed += clues[index];
+  }
+  return needed <= length;
+}
+
+static int _line_settle(int *line, int index, int value) {
+  if (line[index] == NONOGRAM_UNKNOWN) {
+    line[index] = value;
+    return 1;
+  }
+  return 0;
+}
+
+/*
+ * On a line with no known cell, the leftmost and rightmost placements of each
+ * clue are enough: their overlap is filled and cells out of reach of every
+ * clue are empty. The clues are known to fit.
+ */
+static int _line_solve_blank(
+  const int *clues,
+  int clues_count,
+  int *line,
+  int length
+) {
+  int total = clues_count ? clues_count - 1 : 0;
+  for (int index = 0; index < clues_count; index++) {
+    total += clues[index];
+  }
+  int slack = length - total;
+  int settled = 0;
+  int start = 0;
+  for (int index = 0; index < clues_count; index++) {
+    int end = start + clues[index];
+    for (int cell = start + slack; cell < end; cell++) {
+      settled += _line_settle(line, cell, NONOGRAM_FILLED);
+    }
+    start = end + 1;
+  }
+  if (!slack || !clues_count) {
+    for (int cell = 0; cell < length; cell++) {
+      settled += _line_settle(line, cell, NONOGRAM_EMPTY);
+    }
+  }
+  return settled;
+}
+
+/*
+ * Dynamic programming over (clue, position):
+ *   before[j][i]  the first j clues fit in cells [0, i)
+ *   after[j][i]   the clues from j on fit in cells [i, length)
+ * A cell may be empty when some j fits around it, and may be filled when some
+ * clue can be placed over it. Cells that can only take one value are settled.
+ */
+static int _line_solve_dp(
+  const int *clues,
+  int clues_count,
+  int *line,
+  int length
+) {
+  int width = length + 1;
+  size_t planes = (size_t)(clues_count + 1) * width;
+  int *empties = _nonogram_alloc(
+    3 * width * sizeof(int) + 2 * planes + length
+  );
+  if (!empties) {
+    return -2;
+  }
+  int *filled = empties + width;
+  int *coverage = filled + width;
+  unsigned char *before = (unsigned char *)(coverage + width);
+  unsigned char *after = before + planes;
+  unsigned char *may_be_empty = after + planes;
+
+  empties[0] = filled[0] = 0;
+  for (int cell = 0; cell < length; cell++) {
+    empties[cell + 1] = empties[cell] + (line[cell] == NONOGRAM_EMPTY);
+    filled[cell + 1] = filled[cell] + (line[cell] == NONOGRAM_FILLED);
+  }
+#define _BEFORE(j, i) before[(size_t)(j) * width + (i)]
+#define _AFTER(j, i) after[(size_t)(j) * width + (i)]
+#define _FREE(from, to) (empties[to] == empties[from])
+#define _NOT_FILLED(i) (line[i] != NONOGRAM_FILLED)
+
+  for (int cell = 0; cell <= length; cell++) {
+    _BEFORE(0, cell) = filled[cell] == 0;
+  }
+  for (int index = 1; index <= clues_count; index++) {
+    int clue = clues[index - 1];
+    _BEFORE(index, 0) = 0;
+    for (int cell = 1; cell <= length; cell++) {
+      bool fits = _NOT_FILLED(cell - 1) && _BEFORE(index, cell - 1);
+      int start = cell - clue;
+      if (!fits && start >= 0 && _FREE(start, cell)) {
+        if (index == 1) {
+          fits = _BEFORE(0, start);
+        } else {
+          fits = start >= 1 && _NOT_FILLED(start - 1) &&
+                 _BEFORE(index - 1, start - 1);
         }
       }
+      _BEFORE(index, cell) = fits;
     }
-    hints->rows[row][index] = count;
   }
-  for (int col = 0; col < cols_count; col++) {
-    int count = 0;
-    int index = 0;
-    for (int row = 0; row < rows_count; row++) {
-      if (board[row][col] == 1) {
-        count++;
-      } else {
-        if (count > 0) {
-          hints->cols[col][index++] = count;
-          count = 0;
+  if (!_BEFORE(clues_count, length)) {
+    _nonogram_free(empties);
+    return -1;
+  }
+
+  for (int cell = 0; cell <= length; cell++) {
+    _AFTER(clues_count, cell) = filled[length] == filled[cell];
+  }
+  for (int index = clues_count - 1; index >= 0; index--) {
+    int clue = clues[index];
+    _AFTER(index, length) = 0;
+    for (int cell = length - 1; cell >= 0; cell--) {
+      bool fits = _NOT_FILLED(cell) && _AFTER(index, cell + 1);
+      int end = cell + clue;
+      if (!fits && end <= length && _FREE(cell, end)) {
+        if (index == clues_count - 1) {
+          fits = _AFTER(clues_count, end);
+        } else {
+          fits = end < length && _NOT_FILLED(end) &&
+                 _AFTER(index + 1, end + 1);
         }
       }
+      _AFTER(index, cell) = fits;
     }
-    hints->cols[col][index++] = count;
   }
-  return hints;
+
+  for (int cell = 0; cell < length; cell++) {
+    bool empty = false;
+    if (_NOT_FILLED(cell)) {
+      for (int index = 0; index <= clues_count && !empty; index++) {
+        empty = _BEFORE(index, cell) && _AFTER(index, cell + 1);
+      }
+    }
+    may_be_empty[cell] = empty;
+    coverage[cell] = 0;
+  }
+  coverage[length] = 0;
+  for (int index = 0; index < clues_count; index++) {
+    int clue = clues[index];
+    for (int start = 0; start + clue <= length; start++) {
+      int end = start + clue;
+      if (!_FREE(start, end)) {
+        continue;
+      }
+      bool left = index == 0
+        ? _BEFORE(0, start)
+        : start >= 1 && _NOT_FILLED(start - 1) && _BEFORE(index, start - 1);
+      bool right = index == clues_count - 1
+        ? _AFTER(clues_count, end)
+        : end < length && _NOT_FILLED(end) && _AFTER(index + 1, end + 1);
+      if (left && right) {
+        coverage[start]++;
+        coverage[end]--;
+      }
+    }
+  }
+#undef _BEFORE
+#undef _AFTER
+#undef _FREE
+#undef _NOT_FILLED
+
+  int settled = 0;
+  int covered = 0;
+  for (int cell = 0; cell < length; cell++) {
+    covered += coverage[cell];
+    if (covered > 0 && !may_be_empty[cell]) {
+      settled += _line_settle(line, cell, NONOGRAM_FILLED);
+    } else if (covered == 0 && may_be_empty[cell]) {
+      settled += _line_settle(line, cell, NONOGRAM_EMPTY);
+    }
+  }
+  _nonogram_free(empties);
+  return settled;
 }
 
-NonoGramHints *nonogram_hints_create(
-  int **board,
-  int rows_count,
-  int cols_count
+int nonogram_line_solve(
+  const int *clues,
+  int clues_count,
+  int *line,
+  int length
 ) {
-  NonoGramHints *hints = _nonogram_hints_new(rows_count, cols_count);
-  if (hints) {
-    _nonogram_hints_fill(hints, board, rows_count, cols_count);
+  // Clues that cannot fit would also overflow the positions computed below
+  if (!_nonogram_line_fits(clues, clues_count, length)) {
+    return -1;
   }
-  return hints;
+  bool blank = true;
+  for (int cell = 0; cell < length && blank; cell++) {
+    blank = line[cell] == NONOGRAM_UNKNOWN;
+  }
+  if (blank) {
+    return _line_solve_blank(clues, clues_count, line, length);
+  }
+  NonoGramMemo *memo = _nonogram_memo;
+  int settled;
+  if (memo &&
+      _nonogram_memo_find(memo, clues, clues_count, line, length, &settled)) {
+    if (_nonogram_stats) {
+      _nonogram_stats->memo_hits++;
+    }
+    return settled;
+  }
+  settled = _line_solve_dp(clues, clues_count, line, length);
+  // Running out of memory says nothing of the line, and may not last
+  if (memo && settled != -2) {
+    _nonogram_memo_store(memo, line, settled);
+  }
+  return settled;
 }
 
-void nonogram_hints_destroy(NonoGramHints *hints) {
-  for (int row = 0; row < hints->rows_count; row++) {
-    free(hints->rows[row]);
+_Thread_local NonoGramStats *_nonogram_stats = NULL;
+
+NonoGramStats *nonogram_stats_collect(NonoGramStats *stats) {
+  NonoGramStats *previous = _nonogram_stats;
+  _nonogram_stats = stats;
+  return previous;
+}
+
+double _nonogram_stats_clock(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/*
+ * Without threads, lines whose cells changed wait in a binary heap ordered by
+ * expected gain: the cells that changed since the line was last solved, less
+ * its slack, the room the clues have to move along the line. Lines without
+ * clues are settled whole and have no slack.
+ */
+
+static bool _worklist_before(
+  const _NonoGramWorklist *worklist,
+  int line,
+  int other
+) {
+  int gain = worklist->pending[line] - worklist->slacks[line];
+  int other_gain = worklist->pending[other] - worklist->slacks[other];
+  return gain > other_gain || (gain == other_gain && line < other);
+}
+
+void _nonogram_worklist_push(_NonoGramWorklist *worklist, int line) {
+  worklist->pending[line]++;
+  int index = worklist->positions[line];
+  if (index < 0) {
+    index = worklist->count++;
   }
-  for (int col = 0; col < hints->cols_count; col++) {
-    free(hints->cols[col]);
+  while (index > 0) {
+    int parent = (index - 1) / 2;
+    if (!_worklist_before(worklist, line, worklist->heap[parent])) {
+      break;
+    }
+    worklist->heap[index] = worklist->heap[parent];
+    worklist->positions[worklist->heap[index]] = index;
+    index = parent;
   }
-  free(hints->rows);
-  free(hints->cols);
-  free(hints);
+  worklist->heap[index] = line;
+  worklist->positions[line] = index;
+}
+
+static int _worklist_pop(_NonoGramWorklist *worklist) {
+  int *heap = worklist->heap;
+  int line = heap[0];
+  int last = heap[--worklist->count];
+  int index = 0;
+  while (2 * index + 1 < worklist->count) {
+    int child = 2 * index + 1;
+    if (child + 1 < worklist->count &&
+        _worklist_before(worklist, heap[child + 1], heap[child])) {
+      child++;
+    }
+    if (!_worklist_before(worklist, heap[child], last)) {
+      break;
+    }
+    heap[index] = heap[child];
+    worklist->positions[heap[index]] = index;
+    index = child;
+  }
+  heap[index] = last;
+  worklist->positions[last] = index;
+  worklist->positions[line] = -1;
+  worklist->pending[line] = 0;
+  return line;
+}
+
+static void _worklist_clear(_NonoGramWorklist *worklist) {
+  while (worklist->count) {
+    _worklist_pop(worklist);
+  }
+}
+
+/*
+ * Queue the lines crossing the cells of line recorded in changes, and append
+ * the cells to the trail
+ */
+static void _worklist_push_crossings(_NonoGramWorklist *worklist, int line) {
+  const NonoGramBoard *changes = worklist->changes;
+  bool is_col = _NONOGRAM_BOARD_IS_COL(changes, line);
+  int first = is_col ? 0 : changes->rows_count;
+  const uint64_t *filled = _NONOGRAM_BOARD_FILLED(changes, line);
+  const uint64_t *empty = _NONOGRAM_BOARD_EMPTY(changes, line);
+  for (int word = 0; word < _NONOGRAM_BOARD_LINE_WORDS(changes, line); word++) {
+    uint64_t bits = filled[word] | empty[word];
+    while (bits) {
+      int cell = word * _NONOGRAM_WORD_BITS + __builtin_ctzll(bits);
+      _nonogram_worklist_push(worklist, first + cell);
+      if (worklist->sources) {
+        worklist->sources[worklist->trail_count] = line;
+      }
+      if (worklist->trail) {
+        worklist->trail[worklist->trail_count++] = is_col
+          ? cell * changes->cols_count + line - changes->rows_count
+          : line * changes->cols_count + cell;
+      }
+      bits &= bits - 1;
+    }
+  }
+}
+
+static int _worklist_slack(
+  const NonoGramHints *hints,
+  const NonoGramBoard *board,
+  int line
+) {
+  const int *clues = _NONOGRAM_LINE_CLUES(hints, line);
+  int clues_count = _NONOGRAM_LINE_CLUES_COUNT(hints, line);
+  if (!_nonogram_line_fits(clues, clues_count,
+                           _NONOGRAM_BOARD_LENGTH(board, line))) {
+    // First in the queue, as it contradicts at once
+    return -1;
+  }
+  int slack = clues_count ? _NONOGRAM_BOARD_LENGTH(board, line) + 1 : 0;
+  for (int clue = 0; clue < clues_count; clue++) {
+    slack -= clues[clue] + 1;
+  }
+  return slack;
+}
+
+bool _nonogram_worklist_init(
+  _NonoGramWorklist *worklist,
+  NonoGramHints *hints,
+  NonoGramBoard *board,
+  bool trail
+) {
+  int rows_count = hints->rows_count;
+  int cols_count = hints->cols_count;
+  int lines_count = rows_count + cols_count;
+  int length = rows_count > cols_count ? rows_count : cols_count;
+  worklist->hints = hints;
+  worklist->board = board;
+  worklist->changes = nonogram_board_create(rows_count, cols_count);
+  worklist->heap = _nonogram_alloc((4 * lines_count + length) * sizeof(int));
+  worklist->trail = trail
+    ? _nonogram_alloc((size_t)rows_count * cols_count * sizeof(int))
+    : NULL;
+  if (!worklist->changes || !worklist->heap || (trail && !worklist->trail)) {
+    _nonogram_worklist_free(worklist);
+    return false;
+  }
+  worklist->count = 0;
+  worklist->trail_count = 0;
+  worklist->slacks = worklist->heap + lines_count;
+  worklist->pending = worklist->slacks + lines_count;
+  worklist->positions = worklist->pending + lines_count;
+  worklist->cells = worklist->positions + lines_count;
+  memset(worklist->pending, 0, lines_count * sizeof(int));
+  memset(worklist->positions, -1, lines_count * sizeof(int));
+  worklist->sources = NULL;
+  for (int line = 0; line < lines_count; line++) {
+    worklist->slacks[line] = _worklist_slack(hints, board, line);
+  }
+  return true;
+}
+
+void _nonogram_worklist_set_clues(
+  _NonoGramWorklist *worklist,
+  NonoGramHints *hints,
+  int line
+) {
+  worklist->hints = hints;
+  worklist->slacks[line] = _worklist_slack(hints, worklist->board, line);
+  _nonogram_worklist_push(worklist, line);
+}
+
+void _nonogram_worklist_free(_NonoGramWorklist *worklist) {
+  _nonogram_free(worklist->trail);
+  _nonogram_free(worklist->heap);
+  if (worklist->changes) {
+    nonogram_board_destroy(worklist->changes);
+  }
+}
+
+bool _nonogram_worklist_set(
+  _NonoGramWorklist *worklist,
+  int row,
+  int col,
+  int value
+) {
+  NonoGramBoard *board = worklist->board;
+  if (nonogram_board_get(board, row, col) != NONOGRAM_UNKNOWN) {
+    return nonogram_board_get(board, row, col) == value;
+  }
+  nonogram_board_set(board, row, col, value);
+  if (worklist->sources) {
+    worklist->sources[worklist->trail_count] = -1;
+  }
+  if (worklist->trail) {
+    worklist->trail[worklist->trail_count++] = row * board->cols_count + col;
+  }
+  _nonogram_worklist_push(worklist, row);
+  _nonogram_worklist_push(worklist, board->rows_count + col);
+  return true;
+}
+
+int _nonogram_worklist_propagate(_NonoGramWorklist *worklist) {
+  NonoGramHints *hints = worklist->hints;
+  NonoGramBoard *board = worklist->board;
+  NonoGramStats *stats = _nonogram_stats;
+  if (stats) {
+    stats->passes++;
+  }
+  while (worklist->count) {
+    int line = _worklist_pop(worklist);
+    _nonogram_board_get_line(board, line, worklist->cells);
+    int settled = nonogram_line_solve(
+      _NONOGRAM_LINE_CLUES(hints, line),
+      _NONOGRAM_LINE_CLUES_COUNT(hints, line),
+      worklist->cells,
+      _NONOGRAM_BOARD_LENGTH(board, line)
+    );
+    if (stats) {
+      stats->line_solves++;
+      stats->cells_settled += settled > 0 ? settled : 0;
+    }
+    if (settled < 0) {
+      _worklist_clear(worklist);
+      return settled;
+    }
+    if (settled > 0) {
+      _nonogram_board_store_line(board, worklist->changes, line, worklist->cells);
+      _worklist_push_crossings(worklist, line);
+      _nonogram_board_flush_line(board, worklist->changes, line, NULL);
+    }
+  }
+  return 0;
+}
+
+void _nonogram_worklist_undo(_NonoGramWorklist *worklist, int mark) {
+  NonoGramBoard *board = worklist->board;
+  while (worklist->trail_count > mark) {
+    int cell = worklist->trail[--worklist->trail_count];
+    nonogram_board_set(
+      board,
+      cell / board->cols_count,
+      cell % board->cols_count,
+      NONOGRAM_UNKNOWN
+    );
+  }
+}
+
+static int _solve_worklist(NonoGramHints *hints, NonoGramBoard *board) {
+  _NonoGramWorklist worklist;
+  if (!_nonogram_worklist_init(&worklist, hints, board, false)) {
+    return -2;
+  }
+  for (int line = 0; line < hints->rows_count + hints->cols_count; line++) {
+    _nonogram_worklist_push(&worklist, line);
+  }
+  int status = _nonogram_worklist_propagate(&worklist);
+  _nonogram_worklist_free(&worklist);
+  return status < 0 ? status : nonogram_board_get_unknown_count(board);
+}
+
+/*
+ * With threads, propagation alternates a pass over the dirty rows and a pass
+ * over the dirty columns. Within a pass, lines only read and write the planes
+ * of their own orientation, so they can be solved concurrently; the cells they
+ * settle are copied to the crossing planes between passes, marking crossing
+ * lines dirty.
+ */
+
+typedef struct {
+  NonoGramHints *hints;
+  NonoGramBoard *board;
+  NonoGramBoard *changes;    // Cells settled by the current pass
+  int *lines;                // Lines of the current pass
+  int **cells;               // Line buffer of each worker
+  atomic_int failure;         // First negative line solve, or 0
+} _Pass;
+
+static void _pass_task(void *data, int index, int worker) {
+  _Pass *pass = data;
+  if (atomic_load_explicit(&pass->failure, memory_order_relaxed)) {
+    return;
+  }
+  int line = pass->lines[index];
+  int *cells = pass->cells[worker];
+  _nonogram_board_get_line(pass->board, line, cells);
+  int settled = nonogram_line_solve(
+    _NONOGRAM_LINE_CLUES(pass->hints, line),
+    _NONOGRAM_LINE_CLUES_COUNT(pass->hints, line),
+    cells,
+    _NONOGRAM_BOARD_LENGTH(pass->board, line)
+  );
+  if (settled < 0) {
+    int none = 0;
+    atomic_compare_exchange_strong_explicit(
+      &pass->failure, &none, settled, memory_order_relaxed, memory_order_relaxed
+    );
+  } else if (settled > 0) {
+    _nonogram_board_store_line(pass->board, pass->changes, line, cells);
+  }
+}
+
+static int _solve_passes(
+  NonoGramHints *hints,
+  NonoGramBoard *board,
+  NonoGramPool *pool
+) {
+  int rows_count = hints->rows_count;
+  int cols_count = hints->cols_count;
+  int workers_count = nonogram_pool_get_workers_count(pool);
+  int lines_count = rows_count + cols_count;
+  int length = rows_count > cols_count ? rows_count : cols_count;
+
+  _Pass pass;
+  pass.hints = hints;
+  pass.board = board;
+  pass.changes = nonogram_board_create(rows_count, cols_count);
+  pass.lines = _nonogram_alloc(length * sizeof(int));
+  pass.cells = _nonogram_alloc(workers_count * sizeof(int *));
+  int *cells = _nonogram_alloc((size_t)workers_count * length * sizeof(int));
+  unsigned char *dirty = _nonogram_alloc(lines_count);
+  atomic_init(&pass.failure, 0);
+  if (!pass.changes || !pass.lines || !pass.cells || !cells || !dirty) {
+    _nonogram_free(dirty);
+    _nonogram_free(cells);
+    _nonogram_free(pass.cells);
+    _nonogram_free(pass.lines);
+    if (pass.changes) {
+      nonogram_board_destroy(pass.changes);
+    }
+    return -2;
+  }
+  for (int worker = 0; worker < workers_count; worker++) {
+    pass.cells[worker] = cells + (size_t)worker * length;
+  }
+  memset(dirty, 1, lines_count);
+
+  bool is_col = false;
+  int idle = 0;
+  while (idle < 2 && !atomic_load(&pass.failure)) {
+    int first = is_col ? rows_count : 0;
+    int last = is_col ? lines_count : rows_count;
+    int count = 0;
+    for (int line = first; line < last; line++) {
+      if (dirty[line]) {
+        dirty[line] = 0;
+        pass.lines[count++] = line;
+      }
+    }
+    is_col = !is_col;
+    if (!count) {
+      idle++;
+      continue;
+    }
+    idle = 0;
+    if (_nonogram_stats) {
+      _nonogram_stats->passes++;
+      _nonogram_stats->line_solves += count;
+    }
+    if ((long)count * _NONOGRAM_BOARD_LENGTH(board, first) >=
+        NONOGRAM_PARALLEL_MIN_CELLS) {
+      nonogram_pool_run(pool, count, _pass_task, &pass);
+    } else {
+      for (int index = 0; index < count; index++) {
+        _pass_task(&pass, index, 0);
+      }
+    }
+    for (int index = 0; index < count; index++) {
+      _nonogram_board_flush_line(board, pass.changes, pass.lines[index], dirty);
+    }
+  }
+
+  int failure = atomic_load(&pass.failure);
+  _nonogram_free(dirty);
+  _nonogram_free(cells);
+  _nonogram_free(pass.cells);
+  _nonogram_free(pass.lines);
+  nonogram_board_destroy(pass.changes);
+  return failure ? failure : nonogram_board_get_unknown_count(board);
+}
+
+int nonogram_hints_solve_parallel(
+  NonoGramHints *hints,
+  NonoGramBoard *board,
+  NonoGramPool *pool
+) {
+  if (board->rows_count != hints->rows_count ||
+      board->cols_count != hints->cols_count) {
+    return -1;
+  }
+  NonoGramStats *stats = _nonogram_stats;
+  double start = stats ? _nonogram_stats_clock() : 0;
+  int unknown;
+  if (pool && nonogram_pool_get_workers_count(pool) > 1) {
+    // Workers do not see the statistics: cells are counted here
+    int before = stats ? nonogram_board_get_unknown_count(board) : 0;
+    unknown = _solve_passes(hints, board, pool);
+    if (stats) {
+      stats->cells_settled +=
+        before - nonogram_board_get_unknown_count(board);
+    }
+  } else {
+    unknown = _solve_worklist(hints, board);
+  }
+  if (stats) {
+    stats->solve_time += _nonogram_stats_clock() - start;
+  }
+  return unknown;
+}
+
+int nonogram_hints_solve(NonoGramHints *hints, NonoGramBoard *board) {
+  return nonogram_hints_solve_parallel(hints, board, NULL);
+}
+
+/*
+ * Word-wide checks reject lines whose clues do not fit, with cells both
+ * filled and empty or with more filled cells than clues; the line solver
+ * handles the rest.
+ */
+static bool _line_check(
+  NonoGramHints *hints,
+  const NonoGramBoard *board,
+  int line,
+  int *cells
+) {
+  const int *clues = _NONOGRAM_LINE_CLUES(hints, line);
+  int clues_count = _NONOGRAM_LINE_CLUES_COUNT(hints, line);
+  const uint64_t *filled = _NONOGRAM_BOARD_FILLED(board, line);
+  const uint64_t *empty = _NONOGRAM_BOARD_EMPTY(board, line);
+  int words = _NONOGRAM_BOARD_LINE_WORDS(board, line);
+  int length = _NONOGRAM_BOARD_LENGTH(board, line);
+  if (!_nonogram_line_fits(clues, clues_count, length)) {
+    return false;
+  }
+  int total = 0;
+  for (int clue = 0; clue < clues_count; clue++) {
+    total += clues[clue];
+  }
+  int filled_count = 0;
+  uint64_t known = 0;
+  for (int word = 0; word < words; word++) {
+    if (filled[word] & empty[word]) {
+      return false;
+    }
+    filled_count += __builtin_popcountll(filled[word]);
+    known |= filled[word] | empty[word];
+  }
+  if (filled_count > total) {
+    return false;
+  }
+  if (!known) {
+    return true;
+  }
+  _nonogram_board_get_line(board, line, cells);
+  return nonogram_line_solve(clues, clues_count, cells, length) >= 0;
+}
+
+int nonogram_hints_check(NonoGramHints *hints, NonoGramBoard *board) {
+  int rows_count = hints->rows_count;
+  int cols_count = hints->cols_count;
+  if (board->rows_count != rows_count || board->cols_count != cols_count) {
+    return false;
+  }
+  int *cells = _nonogram_alloc(
+    (rows_count > cols_count ? rows_count : cols_count) * sizeof(int)
+  );
+  if (!cells) {
+    return false;
+  }
+  bool consistent = true;
+  for (int line = 0; line < rows_count + cols_count && consistent; line++) {
+    consistent = _line_check(hints, board, line, cells);
+  }
+  _nonogram_free(cells);
+  return consistent;
+}
+
+void nonogram_hints_destroy(NonoGramHints *hints) {
+  if (hints->mapped) {
+    munmap(hints->mapped, hints->mapped_size);
+  }
+  _nonogram_free(hints);
 }
 
 int nonogram_hints_get_rows_count(NonoGramHints *hints) {
@@ -135,85 +942,108 @@ int nonogram_hints_get_cols_count(NonoGramHints *hints) {
 int nonogram_hints_get_row_value(NonoGramHints *hints, int row, int index) {
   assert(row < hints->rows_count);
   assert(index < hints->cols_count);
-  return hints->rows[row][index];
+  if (index < _NONOGRAM_LINE_CLUES_COUNT(hints, row)) {
+    return _NONOGRAM_LINE_CLUES(hints, row)[index];
+  }
+  return 0;
 }
 
 int nonogram_hints_get_col_value(NonoGramHints *hints, int col, int index) {
   assert(col < hints->cols_count);
   assert(index < hints->rows_count);
-  return hints->cols[col][index];
-}
-static bool _add_string(
-  char **pstring,
-  unsigned int *plength,
-  const char *add
-) {
-  if (add) {
-    unsigned int inc_length = strlen(add);
-    char *string = realloc(*pstring, *plength + inc_length + 1);
-    if (string) {
-      *pstring = string;
-      strncpy(*pstring + *plength, add, inc_length + 1);
-      *plength += inc_length;
-      return true;
-    } else {
-      return false;
-    }
-  } else {
-    return false;
+  int line = hints->rows_count + col;
+  if (index < _NONOGRAM_LINE_CLUES_COUNT(hints, line)) {
+    return _NONOGRAM_LINE_CLUES(hints, line)[index];
   }
+  return 0;
 }
-#define _ADD_STRING(pstring, plength, add) \
-  if (!_add_string(pstring, plength, add)) \
-    return NULL;
-
-const char *nonogram_hints_to_string(NonoGramHints *hints) {
-  static char *string = NULL;
-  char buffer[128];
+/*
+ * Formatting writes what fits in the buffer and counts the rest, as snprintf
+ * does, so that the same pass gives the length.
+ */
+typedef struct {
+  char *buffer;
+  size_t size;
+  size_t length;
+} _Writer;
 
-  if (!hints) {
-    free(string);
-    string = NULL;
-    return NULL;
+static void _write(_Writer *writer, const char *string, size_t length) {
+  if (writer->length < writer->size) {
+    size_t room = writer->size - writer->length;
+    memcpy(writer->buffer + writer->length, string,
+           length < room ? length : room);
   }
+  writer->length += length;
+}
 
-  int length = 0;
-  _ADD_STRING(&string, &length, "{");
-
-  _ADD_STRING(&string, &length, "\"rows\":[");
+static void _write_line(_Writer *writer, NonoGramHints *hints, int line) {
+  char digits[16];
+  _write(writer, "[", 1);
+  for (int index = 0; index < _NONOGRAM_LINE_CLUES_COUNT(hints, line); index++) {
+    // Clues are positive: digits are written backwards from the end
+    unsigned int clue = _NONOGRAM_LINE_CLUES(hints, line)[index];
+    char *digit = digits + sizeof digits;
+    do {
+      *--digit = '0' + clue % 10;
+      clue /= 10;
+    } while (clue);
+    if (index > 0) {
+      *--digit = ',';
+    }
+    _write(writer, digit, digits + sizeof digits - digit);
+  }
+  _write(writer, "]", 1);
+}
 
+size_t nonogram_hints_format(
+  NonoGramHints *hints,
+  char *buffer,
+  size_t size
+) {
+  _Writer writer = {buffer, size, 0};
+  _write(&writer, "{\"rows\":[", 9);
   for (int row = 0; row < hints->rows_count; row++) {
-    _ADD_STRING(&string, &length, row > 0 ? "," : "");
-    _ADD_STRING(&string, &length, "[");
-    for (int index = 0; index < hints->cols_count; index++) {
-      if (!hints->rows[row][index]) {
-        break;
-      }
-      _ADD_STRING(&string, &length, index > 0 ? "," : "");
-      snprintf(buffer, sizeof buffer, "%d", hints->rows[row][index]);
-      _ADD_STRING(&string, &length, buffer);
+    if (row > 0) {
+      _write(&writer, ",", 1);
     }
-    _ADD_STRING(&string, &length, "]");
+    _write_line(&writer, hints, row);
   }
-  _ADD_STRING(&string, &length, "]");
-  _ADD_STRING(&string, &length, ",\"cols\":[");
-
+  _write(&writer, "],\"cols\":[", 10);
   for (int col = 0; col < hints->cols_count; col++) {
-    _ADD_STRING(&string, &length, col > 0 ? "," : "");
-    _ADD_STRING(&string, &length, "[");
-    for (int index = 0; index < hints->rows_count; index++) {
-      if (!hints->cols[col][index]) {
-        break;
-      }
-      _ADD_STRING(&string, &length, index > 0 ? "," : "");
-      snprintf(buffer, sizeof buffer, "%d", hints->cols[col][index]);
-      _ADD_STRING(&string, &length, buffer);
+    if (col > 0) {
+      _write(&writer, ",", 1);
     }
-    _ADD_STRING(&string, &length, "]");
+    _write_line(&writer, hints, hints->rows_count + col);
   }
-  _ADD_STRING(&string, &length, "]");
+  _write(&writer, "]}", 2);
+  if (size) {
+    buffer[writer.length < size ? writer.length : size - 1] = '\0';
+  }
+  return writer.length;
+}
 
-  _ADD_STRING(&string, &length, "}");
+const char *nonogram_hints_to_string(NonoGramHints *hints) {
+  // One buffer per thread, grown by doubling and reused across calls
+  static _Thread_local char *string = NULL;
+  static _Thread_local size_t capacity = 0;
 
+  if (!hints) {
+    free(string);
+    string = NULL;
+    capacity = 0;
+    return NULL;
+  }
+
+  size_t length = nonogram_hints_format(hints, string, capacity);
+  if (length >= capacity) {
+    size_t grown = 2 * capacity > length ? 2 * capacity : length + 1;
+    char *resized = realloc(string, grown);
+    if (!resized) {
+      return NULL;
+    }
+    string = resized;
+    capacity = grown;
+    nonogram_hints_format(hints, string, capacity);
+  }
   return string;
 }
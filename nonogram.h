@@ -1,13 +1,48 @@
 #ifndef NONOGRAM_H_
 #define NONOGRAM_H_
+#include <stdint.h>
+#include <stdio.h>
+
 typedef struct _NonoGramHints NonoGramHints;
+typedef struct _NonoGramBoard NonoGramBoard;
+typedef struct _NonoGramPool NonoGramPool;
+typedef struct _NonoGramArena NonoGramArena;
+typedef struct _NonoGramMemo NonoGramMemo;
+typedef struct _NonoGramSession NonoGramSession;
+typedef struct _NonoGramArchive NonoGramArchive;
+typedef struct _NonoGramArchiveWriter NonoGramArchiveWriter;
+typedef struct _NonoGramCache NonoGramCache;
 
+#define NONOGRAM_UNKNOWN -1
+#define NONOGRAM_EMPTY 0
+#define NONOGRAM_FILLED 1
 
 extern NonoGramHints *nonogram_hints_create(
-   int **rows;
-    int **cols;
-    int rows_count;
-    int cols_count;
+  int **board,
+  int rows_count,
+  int cols_count
+);
+
+/* rows and cols are zero-terminated clue lists */
+extern NonoGramHints *nonogram_hints_create_from_clues(
+  int **rows,
+  int **cols,
+  int rows_count,
+  int cols_count
+);
+
+/* filled cells of board give the clues */
+extern NonoGramHints *nonogram_hints_create_from_board(NonoGramBoard *board);
+
+/*
+ * bitmap holds packed rows as in PBM files (see
+ * nonogram_board_create_from_bitmap); set bits give the clues. The bitmap is
+ * read once, row by row.
+ */
+extern NonoGramHints *nonogram_hints_create_from_bitmap(
+  const unsigned char *bitmap,
+  int rows_count,
+  int cols_count
 );
 
 extern void nonogram_hints_destroy(NonoGramHints *hints);
@@ -30,6 +65,363 @@ extern int nonogram_hints_get_col_value(
 );
 
 
+/*
+ * JSON text of hints, in a buffer owned by the calling thread and valid until
+ * its next call; nonogram_hints_to_string(NULL) frees it.
+ */
 extern const char *nonogram_hints_to_string(NonoGramHints *hints);
 
+/*
+ * Write the text of nonogram_hints_to_string into buffer, as snprintf does:
+ * at most size bytes, terminating zero included. Returns the length of the
+ * whole text, so that a size of 0 queries the size to allocate, less one.
+ */
+extern size_t nonogram_hints_format(
+  NonoGramHints *hints,
+  char *buffer,
+  size_t size
+);
+
+/*
+ * Inverse of nonogram_hints_to_string; NULL on malformed input, on a 0 among
+ * other clues (a lone 0 is an empty line) or on clues that do not fit in
+ * their line
+ */
+extern NonoGramHints *nonogram_hints_parse(const char *string);
+
+/* Same as nonogram_hints_parse, reading file in chunks */
+extern NonoGramHints *nonogram_hints_read(FILE *file);
+
+/*
+ * Binary hints: a versioned header, then the offsets and clues tables, each
+ * with the fewest bytes per number that fit, or with ints if in_place is set
+ * (see nonogram_hints_map). buffer is written only if size is at least the
+ * size returned.
+ */
+extern size_t nonogram_hints_pack(
+  NonoGramHints *hints,
+  int in_place,
+  void *buffer,
+  size_t size
+);
+
+/* Inverse of nonogram_hints_pack; NULL on malformed data */
+extern NonoGramHints *nonogram_hints_unpack(const void *buffer, size_t size);
+
+/*
+ * Same as nonogram_hints_unpack, from a file mapped in memory. Tables packed
+ * in place are used as they are, the file staying mapped until the hints are
+ * destroyed.
+ */
+extern NonoGramHints *nonogram_hints_map(const char *path);
+
+
+/*
+ * Settle every cell of line that is forced by clues. Cells hold
+ * NONOGRAM_UNKNOWN, NONOGRAM_EMPTY or NONOGRAM_FILLED. Returns the number of
+ * newly settled cells, -1 if the line contradicts its clues, or -2 on
+ * allocation failure.
+ */
+extern int nonogram_line_solve(
+  const int *clues,
+  int clues_count,
+  int *line,
+  int length
+);
+
+/*
+ * Propagate line logic over rows and columns of board until nothing changes.
+ * Returns the number of cells left unknown, -1 on contradiction, or -2 on
+ * allocation failure.
+ */
+extern int nonogram_hints_solve(NonoGramHints *hints, NonoGramBoard *board);
+
+/*
+ * Same as nonogram_hints_solve, solving the lines of each row or column pass
+ * on the workers of pool. pool may be NULL. Passes with fewer than
+ * NONOGRAM_PARALLEL_MIN_CELLS cells are solved on the calling thread, so
+ * smaller boards never use the pool.
+ */
+#define NONOGRAM_PARALLEL_MIN_CELLS 4096
+
+extern int nonogram_hints_solve_parallel(
+  NonoGramHints *hints,
+  NonoGramBoard *board,
+  NonoGramPool *pool
+);
+
+/*
+ * Beyond line logic, probe every unknown cell with both values: a value that
+ * leads to a contradiction is settled the other way, as are cells both values
+ * settle alike. Returns the number of cells left unknown, -1 on
+ * contradiction, or -2 on allocation failure.
+ */
+extern int nonogram_hints_probe(NonoGramHints *hints, NonoGramBoard *board);
+
+/*
+ * Complete board with line logic and depth-first search on the cells it
+ * leaves unknown. Returns 1 if board now holds a solution, 0 if the hints
+ * have none (board is left as given), -1 on error.
+ */
+extern int nonogram_hints_search(NonoGramHints *hints, NonoGramBoard *board);
+
+/*
+ * Count the solutions of hints that extend board, stopping at the second one:
+ * returns 0, 1, 2 for more than one, or -1 on error. board is left as given.
+ * If witnesses is not NULL, it receives a copy of each solution found, to be
+ * destroyed by the caller, and NULL in the other entries: with 2, the two
+ * solutions differ in at least one cell.
+ */
+extern int nonogram_hints_count_solutions(
+  NonoGramHints *hints,
+  NonoGramBoard *board,
+  NonoGramBoard *witnesses[2]
+);
+
+/* Returns 1 if no row or column of board contradicts its clues */
+extern int nonogram_hints_check(NonoGramHints *hints, NonoGramBoard *board);
+
+/* Counters of the solving functions; times are in seconds */
+typedef struct {
+  long line_solves;     // Calls to the line solver
+  long cells_settled;   // Cells settled by the line solver
+  long passes;          // Row or column passes, or runs of the line queue
+  long probes;          // Values tried by probing
+  long search_nodes;    // Values tried by search
+  long backtracks;      // Decisions undone by search
+  long memo_hits;       // Line solves answered by the memo table
+  int max_depth;        // Most decisions stacked by search
+  double solve_time;    // Time in line logic
+  double probe_time;    // Time probing
+  double search_time;   // Time searching, or counting solutions
+} NonoGramStats;
+
+/*
+ * Add to stats what the solving functions called by this thread do, until
+ * called again; NULL stops collecting. Returns the stats collected before.
+ */
+extern NonoGramStats *nonogram_stats_collect(NonoGramStats *stats);
+
+
+/*
+ * Bit-packed board: one plane of known filled cells and one of known empty
+ * cells, stored both row by row and column by column.
+ */
+extern NonoGramBoard *nonogram_board_create(int rows_count, int cols_count);
+
+extern NonoGramBoard *nonogram_board_copy(const NonoGramBoard *board);
+
+/* cells hold NONOGRAM_UNKNOWN, NONOGRAM_EMPTY or NONOGRAM_FILLED */
+extern NonoGramBoard *nonogram_board_create_from_array(
+  int **cells,
+  int rows_count,
+  int cols_count
+);
+
+/*
+ * bitmap holds packed rows as in PBM files: one bit per cell, first cell in
+ * the most significant bit, rows padded to whole bytes. Set bits are filled
+ * cells, the others are left unknown.
+ */
+extern NonoGramBoard *nonogram_board_create_from_bitmap(
+  const unsigned char *bitmap,
+  int rows_count,
+  int cols_count
+);
+
+extern void nonogram_board_destroy(NonoGramBoard *board);
+
+extern int nonogram_board_get_rows_count(NonoGramBoard *board);
+
+extern int nonogram_board_get_cols_count(NonoGramBoard *board);
+
+extern int nonogram_board_get(NonoGramBoard *board, int row, int col);
+
+extern void nonogram_board_set(
+  NonoGramBoard *board,
+  int row,
+  int col,
+  int value
+);
+
+extern int nonogram_board_get_unknown_count(NonoGramBoard *board);
+
+
+/*
+ * Archive of puzzles, each with its hints, and optionally an initial board
+ * and a known solution, behind an index read in place from the mapped file.
+ * Hints read from an archive written in place must not outlive it.
+ */
+extern NonoGramArchive *nonogram_archive_open(const char *path);
+
+extern void nonogram_archive_close(NonoGramArchive *archive);
+
+extern int nonogram_archive_get_count(NonoGramArchive *archive);
+
+/*
+ * Read puzzle index into the non-NULL ones of hints, board and solution, to
+ * be destroyed by the caller; board and solution receive NULL if the puzzle
+ * has none. Returns 1, or 0 if index is out of range or the puzzle is
+ * malformed.
+ */
+extern int nonogram_archive_get(
+  NonoGramArchive *archive,
+  int index,
+  NonoGramHints **hints,
+  NonoGramBoard **board,
+  NonoGramBoard **solution
+);
+
+/*
+ * Write an archive to file, puzzle after puzzle; hints are packed as by
+ * nonogram_hints_pack. The archive is complete once the writer is closed.
+ * Both return 1 on success.
+ */
+extern NonoGramArchiveWriter *nonogram_archive_writer_create(
+  FILE *file,
+  int in_place
+);
+
+extern int nonogram_archive_writer_add(
+  NonoGramArchiveWriter *writer,
+  NonoGramHints *hints,
+  NonoGramBoard *board,
+  NonoGramBoard *solution
+);
+
+extern int nonogram_archive_writer_close(NonoGramArchiveWriter *writer);
+
+
+/*
+ * Hash of hints, the same for the 8 images of the puzzle under the rotations
+ * and mirror images of the board
+ */
+extern uint64_t nonogram_hints_hash(NonoGramHints *hints);
+/*
+ * Solution cache in directory path, created if missing, which threads and
+ * processes may share. Solutions are looked up by nonogram_hints_hash, so
+ * that a puzzle rotated or mirrored finds the solution of the original.
+ */
+extern NonoGramCache *nonogram_cache_open(const char *path);
+extern void nonogram_cache_close(NonoGramCache *cache);
+/* Solution of hints, to be destroyed by the caller, or NULL if not cached */
+extern NonoGramBoard *nonogram_cache_get(
+  NonoGramCache *cache,
+  NonoGramHints *hints
+);
+/* Store solution, a complete board agreeing with hints; returns 1 if stored */
+extern int nonogram_cache_put(
+  NonoGramCache *cache,
+  NonoGramHints *hints,
+  NonoGramBoard *solution
+);
+/*
+ * Work-stealing thread pool. nonogram_pool_run() calls task(data, index,
+ * worker) once for every index below tasks_count, spread over the workers,
+ * and returns when all are done. The caller takes part as worker 0. Tasks
+ * must not run a job on the same pool.
+ */
+typedef void (*NonoGramTask)(void *data, int index, int worker);
+
+extern NonoGramPool *nonogram_pool_create(int workers_count);
+
+extern void nonogram_pool_destroy(NonoGramPool *pool);
+
+extern int nonogram_pool_get_workers_count(NonoGramPool *pool);
+
+extern void nonogram_pool_run(
+  NonoGramPool *pool,
+  int tasks_count,
+  NonoGramTask task,
+  void *data
+);
+
+
+/*
+ * Bump arenas for the hints, boards and scratch buffers of one puzzle. Once
+ * nonogram_arena_use() made an arena current in a thread, the hints and
+ * boards that thread creates, and everything the solving functions need on
+ * the way, come out of it. Destroying them is then almost free; they must be
+ * destroyed, or no longer used, before nonogram_arena_reset() makes the
+ * whole arena available again. Archives, caches, memo tables, pools, writers
+ * and sessions never live in an arena.
+ */
+extern NonoGramArena *nonogram_arena_create(size_t size);
+
+extern void nonogram_arena_destroy(NonoGramArena *arena);
+
+extern void nonogram_arena_reset(NonoGramArena *arena);
+
+/* Bytes held by the arena, which only grows */
+extern size_t nonogram_arena_get_size(NonoGramArena *arena);
+
+/* Make arena current in this thread, NULL for none. Returns the previous. */
+extern NonoGramArena *nonogram_arena_use(NonoGramArena *arena);
+
+
+/*
+ * Memo tables of line solves. Once nonogram_memo_use() made a table current
+ * in a thread, the line solver looks up there every line with known cells
+ * that it is asked to solve, and keeps the outcome. Probing and search,
+ * which solve the same lines over and over as they try and undo values, are
+ * the ones to benefit. A table holds at most entries line solves, 0 for a
+ * default size, making room by dropping the entries least recently used. It
+ * may serve one puzzle after the other, but only one thread at a time.
+ */
+extern NonoGramMemo *nonogram_memo_create(size_t entries);
+extern void nonogram_memo_destroy(NonoGramMemo *memo);
+/* Drop every entry */
+extern void nonogram_memo_clear(NonoGramMemo *memo);
+/* Entries the table can hold */
+extern size_t nonogram_memo_get_size(NonoGramMemo *memo);
+/* Make memo current in this thread, NULL for none. Returns the previous. */
+extern NonoGramMemo *nonogram_memo_use(NonoGramMemo *memo);
+/*
+ * Solver sessions, for puzzles edited one change at a time. A session owns a
+ * copy of the hints and a board kept at the fixpoint of line logic
+ * (nonogram_hints_solve) under the clues and the cells fixed so far. A
+ * change only undoes the deductions that depended on what it changed, and
+ * is propagated once the status or the board is asked for, reusing the rest
+ * of the previous solution. Changes return 0, or -1 on invalid arguments or
+ * allocation failure, the session being left as it was.
+ */
+extern NonoGramSession *nonogram_session_create(NonoGramHints *hints);
+
+extern void nonogram_session_destroy(NonoGramSession *session);
+
+/*
+ * Fix a cell to NONOGRAM_EMPTY or NONOGRAM_FILLED, or release it with
+ * NONOGRAM_UNKNOWN
+ */
+extern int nonogram_session_set_cell(
+  NonoGramSession *session,
+  int row,
+  int col,
+  int value
+);
+
+/* Replace the clues of a line with a zero-terminated clue list */
+extern int nonogram_session_set_row_clues(
+  NonoGramSession *session,
+  int row,
+  const int *clues
+);
+
+extern int nonogram_session_set_col_clues(
+  NonoGramSession *session,
+  int col,
+  const int *clues
+);
+
+/*
+ * Number of cells left unknown, -1 on contradiction, or -2 on allocation
+ * failure, which the next call tries again
+ */
+extern int nonogram_session_get_status(NonoGramSession *session);
+
+/* Hints and board of the session, owned by it and not to be changed */
+extern NonoGramHints *nonogram_session_get_hints(NonoGramSession *session);
+
+extern NonoGramBoard *nonogram_session_get_board(NonoGramSession *session);
+
 #endif
@@ -316,6 +316,50 @@ void read_pbm_data(FILE *f, int *img_in, int is_ascii)
   } 
 }
 
+/* read_pbm_bits:
+ * Read the data contents of a PBM (portable bit map) file as packed rows:
+ * one bit per pixel, most significant bit first, each row padded to a
+ * whole number of bytes (the P4 layout). The raster is read with fread in
+ * large blocks; P1 digits are decoded without going through fscanf.
+ * Return TRUE if the whole raster could be read.
+ */
+int read_pbm_bits(FILE *f, unsigned char *bits, int x_size, int y_size,
+  int is_ascii)
+{
+  size_t stride = (x_size + 7) / 8;
+  size_t size = stride * y_size;
+  unsigned char buffer[65536];
+  size_t n, k;
+  int x = 0, y = 0, comment = 0;
+
+  if (is_ascii != 1) {
+    return (fread(bits, 1, size, f) == size) ? TRUE : FALSE;
+  }
+
+  memset(bits, 0, size);
+  while (y < y_size && (n = fread(buffer, 1, sizeof(buffer), f)) > 0) {
+    for (k = 0; k < n && y < y_size; k++) {
+      int c = buffer[k];
+      if (comment) {
+        comment = (c != '\n') && (c != '\r');
+      } else if (c == '0' || c == '1') {
+        if (c == '1') {
+          bits[y*stride + x/8] |= 0x80 >> (x % 8);
+        }
+        if (++x == x_size) {
+          x = 0;
+          y++;
+        }
+      } else if (c == '#') {
+        comment = 1;
+      } else if (!isspace(c)) {
+        return (FALSE);
+      }
+    }
+  }
+  return (y == y_size) ? TRUE : FALSE;
+}
+
 /* read_pgm_data:
  * Read the data contents of a PGM (portable grey map) file.
  */
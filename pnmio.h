@@ -35,6 +35,8 @@ int read_ppm_header(FILE *f, int *img_xdim, int *img_ydim, int *img_colors,
 int read_pfm_header(FILE *f, int *img_xdim, int *img_ydim, int *img_type,
        int *endianess);
 void read_pbm_data(FILE *f, int *img_in, int is_ascii);
+int  read_pbm_bits(FILE *f, unsigned char *bits, int x_size, int y_size,
+       int is_ascii);
 void read_pgm_data(FILE *f, int *img_in, int is_ascii);
 void read_ppm_data(FILE *f, int *img_in, int is_ascii);
 void read_pfm_data(FILE *f, float *img_in, int img_type, int endianess);
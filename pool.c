@@ -0,0 +1,202 @@
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "./nonogram.h"
+#include "./nonogram.inc"
+
+/*
+ * Each job is split in one range of task indices per worker. A worker runs
+ * its own range from the front; once it is empty, it steals the back half of
+ * another worker's range, so long tasks do not leave workers idle.
+ */
+
+typedef struct {
+  pthread_mutex_t mutex;
+  int begin;  // Next task to run
+  int end;    // One past the last task
+  char padding[64];
+} _Range;
+
+struct _NonoGramPool {
+  int workers_count;
+  pthread_t *threads;      // Workers 1 and up; the caller of a job is worker 0
+  _Range *ranges;          // Remaining tasks of each worker
+  pthread_mutex_t mutex;
+  pthread_cond_t started;  // A job was posted, or the pool is stopping
+  pthread_cond_t finished; // Every thread is done with the job
+  unsigned long job;       // Number of jobs posted so far
+  int running;             // Threads still busy with the current job
+  bool stopping;
+  NonoGramTask task;
+  void *data;
+};
+
+typedef struct {
+  NonoGramPool *pool;
+  int worker;
+} _Worker;
+
+static bool _pop(_Range *range, int *index) {
+  pthread_mutex_lock(&range->mutex);
+  bool found = range->begin < range->end;
+  if (found) {
+    *index = range->begin++;
+  }
+  pthread_mutex_unlock(&range->mutex);
+  return found;
+}
+
+static bool _steal(NonoGramPool *pool, int worker, int *index) {
+  for (int offset = 1; offset < pool->workers_count; offset++) {
+    _Range *victim = &pool->ranges[(worker + offset) % pool->workers_count];
+    pthread_mutex_lock(&victim->mutex);
+    int remaining = victim->end - victim->begin;
+    int end = victim->end;
+    int begin = end - (remaining + 1) / 2;
+    if (remaining > 0) {
+      victim->end = begin;
+    }
+    pthread_mutex_unlock(&victim->mutex);
+    if (remaining > 0) {
+      _Range *range = &pool->ranges[worker];
+      pthread_mutex_lock(&range->mutex);
+      range->begin = begin + 1;
+      range->end = end;
+      pthread_mutex_unlock(&range->mutex);
+      *index = begin;
+      return true;
+    }
+  }
+  return false;
+}
+
+static void _work(NonoGramPool *pool, int worker) {
+  int index;
+  while (_pop(&pool->ranges[worker], &index) ||
+         _steal(pool, worker, &index)) {
+    pool->task(pool->data, index, worker);
+  }
+}
+
+static void *_thread(void *data) {
+  _Worker *self = data;
+  NonoGramPool *pool = self->pool;
+  unsigned long seen = 0;
+  for (;;) {
+    pthread_mutex_lock(&pool->mutex);
+    while (pool->job == seen && !pool->stopping) {
+      pthread_cond_wait(&pool->started, &pool->mutex);
+    }
+    if (pool->stopping) {
+      pthread_mutex_unlock(&pool->mutex);
+      break;
+    }
+    seen = pool->job;
+    pthread_mutex_unlock(&pool->mutex);
+
+    _work(pool, self->worker);
+
+    pthread_mutex_lock(&pool->mutex);
+    if (--pool->running == 0) {
+      pthread_cond_signal(&pool->finished);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+  }
+  free(self);
+  return NULL;
+}
+
+NonoGramPool *nonogram_pool_create(int workers_count) {
+  if (workers_count < 1) {
+    return NULL;
+  }
+  NonoGramPool *pool = calloc(1, sizeof(NonoGramPool));
+  if (!pool) {
+    return NULL;
+  }
+  pool->workers_count = workers_count;
+  pool->threads = malloc(workers_count * sizeof(pthread_t));
+  pool->ranges = calloc(workers_count, sizeof(_Range));
+  if (!pool->threads || !pool->ranges) {
+    free(pool->threads);
+    free(pool->ranges);
+    free(pool);
+    return NULL;
+  }
+  pthread_mutex_init(&pool->mutex, NULL);
+  pthread_cond_init(&pool->started, NULL);
+  pthread_cond_init(&pool->finished, NULL);
+  for (int worker = 0; worker < workers_count; worker++) {
+    pthread_mutex_init(&pool->ranges[worker].mutex, NULL);
+  }
+  for (int worker = 1; worker < workers_count; worker++) {
+    _Worker *self = malloc(sizeof(_Worker));
+    if (self) {
+      self->pool = pool;
+      self->worker = worker;
+    }
+    if (!self || pthread_create(&pool->threads[worker], NULL, _thread, self)) {
+      // Run with the threads started so far
+      free(self);
+      pool->workers_count = worker;
+      break;
+    }
+  }
+  return pool;
+}
+
+void nonogram_pool_destroy(NonoGramPool *pool) {
+  pthread_mutex_lock(&pool->mutex);
+  pool->stopping = true;
+  pthread_cond_broadcast(&pool->started);
+  pthread_mutex_unlock(&pool->mutex);
+  for (int worker = 1; worker < pool->workers_count; worker++) {
+    pthread_join(pool->threads[worker], NULL);
+  }
+  for (int worker = 0; worker < pool->workers_count; worker++) {
+    pthread_mutex_destroy(&pool->ranges[worker].mutex);
+  }
+  pthread_mutex_destroy(&pool->mutex);
+  pthread_cond_destroy(&pool->started);
+  pthread_cond_destroy(&pool->finished);
+  free(pool->threads);
+  free(pool->ranges);
+  free(pool);
+}
+
+int nonogram_pool_get_workers_count(NonoGramPool *pool) {
+  return pool->workers_count;
+}
+
+void nonogram_pool_run(
+  NonoGramPool *pool,
+  int tasks_count,
+  NonoGramTask task,
+  void *data
+) {
+  if (tasks_count <= 0) {
+    return;
+  }
+  int workers_count = pool->workers_count;
+  for (int worker = 0; worker < workers_count; worker++) {
+    _Range *range = &pool->ranges[worker];
+    range->begin = (int)((long)tasks_count * worker / workers_count);
+    range->end = (int)((long)tasks_count * (worker + 1) / workers_count);
+  }
+  pthread_mutex_lock(&pool->mutex);
+  pool->task = task;
+  pool->data = data;
+  pool->running = workers_count - 1;
+  pool->job++;
+  pthread_cond_broadcast(&pool->started);
+  pthread_mutex_unlock(&pool->mutex);
+
+  _work(pool, 0);
+
+  pthread_mutex_lock(&pool->mutex);
+  while (pool->running > 0) {
+    pthread_cond_wait(&pool->finished, &pool->mutex);
+  }
+  pthread_mutex_unlock(&pool->mutex);
+}
@@ -0,0 +1,203 @@
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "./nonogram.h"
+#include "./nonogram.inc"
+
+/*
+ * Probing sets an unknown cell to filled, propagates, undoes, then does the
+ * same with empty. A value leading to a contradiction is settled the other
+ * way; cells that both values settle alike are settled too. Snapshots are
+ * trail marks, so a probe costs its propagation and nothing more.
+ *
+ * Probes that succeed are cached: every cell a probe settled is safe with
+ * that value, as probing it could only settle a subset of the same cells.
+ * The cache is valid until the next cell is settled for good.
+ */
+
+typedef struct {
+  _NonoGramWorklist worklist;
+  NonoGramBoard *safe;       // Values of cells known not to contradict
+  int *implied;              // Cells settled by the filled probe, as
+                             // 2 * cell + 1 if filled, 2 * cell if empty
+  int implied_count;
+} _Probe;
+
+static uint64_t *_safe_word(_Probe *probe, int cell, int value) {
+  NonoGramBoard *safe = probe->safe;
+  uint64_t *plane = value == NONOGRAM_FILLED ? safe->filled : safe->empty;
+  return plane + (size_t)(cell / safe->cols_count) * safe->row_words +
+    cell % safe->cols_count / _NONOGRAM_WORD_BITS;
+}
+
+static bool _is_safe(_Probe *probe, int cell, int value) {
+  return *_safe_word(probe, cell, value) &
+    _NONOGRAM_BIT(cell % probe->safe->cols_count);
+}
+
+static void _clear_safe(_Probe *probe) {
+  size_t words = (size_t)probe->safe->rows_count * probe->safe->row_words;
+  memset(probe->safe->filled, 0, words * sizeof(uint64_t));
+  memset(probe->safe->empty, 0, words * sizeof(uint64_t));
+}
+
+static int _cell_value(const NonoGramBoard *board, int cell) {
+  return nonogram_board_get(
+    (NonoGramBoard *)board,
+    cell / board->cols_count,
+    cell % board->cols_count
+  );
+}
+
+/*
+ * Try value on cell and undo, returning the propagation status. On success,
+ * the cells settled are cached as safe and, for the filled probe, kept in
+ * implied; for the empty probe, implied is narrowed to the cells settled
+ * alike.
+ */
+static int _try(_Probe *probe, int cell, int value) {
+  _NonoGramWorklist *worklist = &probe->worklist;
+  NonoGramBoard *board = worklist->board;
+  int mark = worklist->trail_count;
+  if (_nonogram_stats) {
+    _nonogram_stats->probes++;
+  }
+  _nonogram_worklist_set(
+    worklist, cell / board->cols_count, cell % board->cols_count, value
+  );
+  int status = _nonogram_worklist_propagate(worklist);
+  if (!status) {
+    for (int index = mark; index < worklist->trail_count; index++) {
+      int settled = worklist->trail[index];
+      int settled_value = _cell_value(board, settled);
+      *_safe_word(probe, settled, settled_value) |=
+        _NONOGRAM_BIT(settled % board->cols_count);
+      if (value == NONOGRAM_FILLED && settled != cell) {
+        probe->implied[probe->implied_count++] =
+          2 * settled + (settled_value == NONOGRAM_FILLED);
+      }
+    }
+    if (value == NONOGRAM_EMPTY) {
+      int count = 0;
+      for (int index = 0; index < probe->implied_count; index++) {
+        int implied = probe->implied[index];
+        if (_cell_value(board, implied / 2) == implied % 2) {
+          probe->implied[count++] = implied;
+        }
+      }
+      probe->implied_count = count;
+    }
+  }
+  _nonogram_worklist_undo(worklist, mark);
+  return status;
+}
+
+/* Settle cell for good. Returns the propagation status. */
+static int _settle(_Probe *probe, int cell, int value) {
+  NonoGramBoard *board = probe->worklist.board;
+  _clear_safe(probe);
+  if (!_nonogram_worklist_set(
+        &probe->worklist,
+        cell / board->cols_count,
+        cell % board->cols_count,
+        value
+      )) {
+    return -1;
+  }
+  return _nonogram_worklist_propagate(&probe->worklist);
+}
+
+/*
+ * Probe cell both ways. Returns 1 if it settled cells, -1 on contradiction,
+ * -2 on allocation failure.
+ */
+static int _probe_cell(_Probe *probe, int cell) {
+  probe->implied_count = 0;
+  bool filled_cached = _is_safe(probe, cell, NONOGRAM_FILLED);
+  int status = filled_cached ? 0 : _try(probe, cell, NONOGRAM_FILLED);
+  if (status == -1) {
+    status = _settle(probe, cell, NONOGRAM_EMPTY);
+    return status < 0 ? status : 1;
+  }
+  // Running out of memory says nothing of the value tried
+  if (status < 0) {
+    return status;
+  }
+  bool empty_cached = _is_safe(probe, cell, NONOGRAM_EMPTY);
+  status = empty_cached ? 0 : _try(probe, cell, NONOGRAM_EMPTY);
+  if (status == -1) {
+    status = _settle(probe, cell, NONOGRAM_FILLED);
+    return status < 0 ? status : 1;
+  }
+  if (status < 0) {
+    return status;
+  }
+  // Cached probes leave no cells to compare
+  if (filled_cached || empty_cached || !probe->implied_count) {
+    return 0;
+  }
+  for (int index = 0; index < probe->implied_count; index++) {
+    int implied = probe->implied[index];
+    if (_cell_value(probe->worklist.board, implied / 2) == NONOGRAM_UNKNOWN) {
+      status = _settle(probe, implied / 2, implied % 2);
+      if (status < 0) {
+        return status;
+      }
+    }
+  }
+  return 1;
+}
+
+int nonogram_hints_probe(NonoGramHints *hints, NonoGramBoard *board) {
+  int rows_count = hints->rows_count;
+  int cols_count = hints->cols_count;
+  if (board->rows_count != rows_count || board->cols_count != cols_count) {
+    return -1;
+  }
+  _Probe probe;
+  if (!_nonogram_worklist_init(&probe.worklist, hints, board, true)) {
+    return -2;
+  }
+  probe.safe = nonogram_board_create(rows_count, cols_count);
+  probe.implied = _nonogram_alloc(
+    (size_t)rows_count * cols_count * sizeof(int)
+  );
+  if (!probe.safe || !probe.implied) {
+    _nonogram_free(probe.implied);
+    if (probe.safe) {
+      nonogram_board_destroy(probe.safe);
+    }
+    _nonogram_worklist_free(&probe.worklist);
+    return -2;
+  }
+
+  NonoGramStats *stats = _nonogram_stats;
+  double start = stats ? _nonogram_stats_clock() : 0;
+  for (int line = 0; line < rows_count + cols_count; line++) {
+    _nonogram_worklist_push(&probe.worklist, line);
+  }
+  int status = _nonogram_worklist_propagate(&probe.worklist);
+  if (!status) {
+    status = 1;
+  }
+  // Probe every unknown cell until a round settles nothing
+  int cells_count = rows_count * cols_count;
+  while (status > 0) {
+    status = 0;
+    for (int cell = 0; cell < cells_count && status >= 0; cell++) {
+      if (_cell_value(board, cell) == NONOGRAM_UNKNOWN) {
+        int settled = _probe_cell(&probe, cell);
+        status = settled < 0 ? settled : status | settled;
+      }
+    }
+  }
+
+  if (stats) {
+    stats->probe_time += _nonogram_stats_clock() - start;
+  }
+  _nonogram_free(probe.implied);
+  nonogram_board_destroy(probe.safe);
+  _nonogram_worklist_free(&probe.worklist);
+  return status < 0 ? status : nonogram_board_get_unknown_count(board);
+}
@@ -0,0 +1,222 @@
+#include <limits.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "./nonogram.h"
+#include "./nonogram.inc"
+
+/*
+ * Depth-first search over the cells line logic leaves unknown. Each decision
+ * sets the most constrained unknown cell, filled first, then empty, and
+ * propagates; a contradiction undoes the trail back to the last decision with
+ * a value left to try. Decisions and trail are both bounded by the board
+ * size, however deep the search goes. Counting solutions backtracks from
+ * each solution found as from a contradiction.
+ */
+
+typedef struct {
+  int cell;   // row * cols_count + col
+  int mark;   // Trail length before the decision
+  int value;  // Value being tried
+} _Decision;
+
+static int _line_unknown_count(const NonoGramBoard *board, int line) {
+  const uint64_t *filled = _NONOGRAM_BOARD_FILLED(board, line);
+  const uint64_t *empty = _NONOGRAM_BOARD_EMPTY(board, line);
+  int count = _NONOGRAM_BOARD_LENGTH(board, line);
+  for (int word = 0; word < _NONOGRAM_BOARD_LINE_WORDS(board, line); word++) {
+    count -= __builtin_popcountll(filled[word] | empty[word]);
+  }
+  return count;
+}
+
+static int _is_filled(const NonoGramBoard *board, int row, int col) {
+  if (row < 0 || row >= board->rows_count ||
+      col < 0 || col >= board->cols_count) {
+    return 0;
+  }
+  return board->filled[(size_t)row * board->row_words +
+                       col / _NONOGRAM_WORD_BITS] >>
+         (col % _NONOGRAM_WORD_BITS) & 1;
+}
+
+/*
+ * Pick the unknown cell with the most filled neighbours, as it decides
+ * whether the runs next to it grow, then with the fewest unknown cells on
+ * its row and column. Returns -1 if none is left.
+ */
+static int _choose_cell(const NonoGramBoard *board, int *unknown_counts) {
+  int rows_count = board->rows_count;
+  int cols_count = board->cols_count;
+  for (int line = 0; line < rows_count + cols_count; line++) {
+    unknown_counts[line] = _line_unknown_count(board, line);
+  }
+  int best_cell = -1;
+  int best_neighbours = -1;
+  int best_count = INT_MAX;
+  for (int row = 0; row < rows_count; row++) {
+    if (!unknown_counts[row]) {
+      continue;
+    }
+    const uint64_t *filled = _NONOGRAM_BOARD_FILLED(board, row);
+    const uint64_t *empty = _NONOGRAM_BOARD_EMPTY(board, row);
+    for (int word = 0; word < board->row_words; word++) {
+      uint64_t bits = ~(filled[word] | empty[word]);
+      while (bits) {
+        int col = word * _NONOGRAM_WORD_BITS + __builtin_ctzll(bits);
+        if (col >= cols_count) {
+          break;
+        }
+        int neighbours = _is_filled(board, row - 1, col) +
+          _is_filled(board, row + 1, col) +
+          _is_filled(board, row, col - 1) +
+          _is_filled(board, row, col + 1);
+        int count = unknown_counts[row] + unknown_counts[rows_count + col];
+        if (neighbours > best_neighbours ||
+            (neighbours == best_neighbours && count < best_count)) {
+          best_cell = row * cols_count + col;
+          best_neighbours = neighbours;
+          best_count = count;
+        }
+        bits &= bits - 1;
+      }
+    }
+  }
+  return best_cell;
+}
+
+/*
+ * Search until limit solutions are found or none is left, copying them into
+ * witnesses if not NULL. The board keeps the last solution found if the limit
+ * is reached and restore is false; otherwise it is left as given. Returns the
+ * number of solutions found, or -1 on error.
+ */
+static int _search(
+  NonoGramHints *hints,
+  NonoGramBoard *board,
+  int limit,
+  NonoGramBoard **witnesses,
+  bool restore
+) {
+  int rows_count = hints->rows_count;
+  int cols_count = hints->cols_count;
+  if (board->rows_count != rows_count || board->cols_count != cols_count) {
+    return -1;
+  }
+  _NonoGramWorklist worklist;
+  if (!_nonogram_worklist_init(&worklist, hints, board, true)) {
+    return -1;
+  }
+  _Decision *decisions = _nonogram_alloc(
+    (size_t)rows_count * cols_count * sizeof(_Decision)
+  );
+  int *unknown_counts = _nonogram_alloc(
+    (rows_count + cols_count) * sizeof(int)
+  );
+  if (!decisions || !unknown_counts) {
+    _nonogram_free(unknown_counts);
+    _nonogram_free(decisions);
+    _nonogram_worklist_free(&worklist);
+    return -1;
+  }
+
+  NonoGramStats *stats = _nonogram_stats;
+  double start = stats ? _nonogram_stats_clock() : 0;
+  for (int line = 0; line < rows_count + cols_count; line++) {
+    _nonogram_worklist_push(&worklist, line);
+  }
+  int status = _nonogram_worklist_propagate(&worklist);
+  int depth = 0;
+  int found = 0;
+  for (;;) {
+    _Decision *decision;
+    // Running out of memory is no contradiction: no branch may be pruned
+    if (status == -2) {
+      found = -1;
+      break;
+    }
+    if (!status) {
+      int cell = _choose_cell(board, unknown_counts);
+      if (cell < 0) {
+        if (witnesses) {
+          witnesses[found] = nonogram_board_copy(board);
+          if (!witnesses[found]) {
+            found = -1;
+            break;
+          }
+        }
+        if (++found == limit) {
+          break;
+        }
+        // Backtrack as from a contradiction to find the next one
+        status = -1;
+        continue;
+      }
+      decision = &decisions[depth++];
+      if (stats && depth > stats->max_depth) {
+        stats->max_depth = depth;
+      }
+      decision->cell = cell;
+      decision->mark = worklist.trail_count;
+      decision->value = NONOGRAM_FILLED;
+    } else {
+      while (depth > 0 && decisions[depth - 1].value == NONOGRAM_EMPTY) {
+        depth--;
+      }
+      if (!depth) {
+        break;
+      }
+      decision = &decisions[depth - 1];
+      _nonogram_worklist_undo(&worklist, decision->mark);
+      decision->value = NONOGRAM_EMPTY;
+      if (stats) {
+        stats->backtracks++;
+      }
+    }
+    if (stats) {
+      stats->search_nodes++;
+    }
+    _nonogram_worklist_set(
+      &worklist,
+      decision->cell / cols_count,
+      decision->cell % cols_count,
+      decision->value
+    );
+    status = _nonogram_worklist_propagate(&worklist);
+  }
+
+  if (restore || found != limit) {
+    _nonogram_worklist_undo(&worklist, 0);
+  }
+  if (stats) {
+    stats->search_time += _nonogram_stats_clock() - start;
+  }
+  _nonogram_free(unknown_counts);
+  _nonogram_free(decisions);
+  _nonogram_worklist_free(&worklist);
+  return found;
+}
+
+int nonogram_hints_search(NonoGramHints *hints, NonoGramBoard *board) {
+  return _search(hints, board, 1, NULL, false);
+}
+
+int nonogram_hints_count_solutions(
+  NonoGramHints *hints,
+  NonoGramBoard *board,
+  NonoGramBoard *witnesses[2]
+) {
+  if (witnesses) {
+    witnesses[0] = witnesses[1] = NULL;
+  }
+  int found = _search(hints, board, 2, witnesses, true);
+  if (found < 0 && witnesses) {
+    for (int index = 0; index < 2; index++) {
+      if (witnesses[index]) {
+        nonogram_board_destroy(witnesses[index]);
+        witnesses[index] = NULL;
+      }
+    }
+  }
+  return found;
+}
@@ -0,0 +1,353 @@
+#include <limits.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "./nonogram.h"
+#include "./nonogram.inc"
+
+/*
+ * A session keeps the board at the fixpoint of line logic, with a trail of
+ * the cells settled in order and the line that settled each. A cell a line
+ * settled only depends on the clues of that line and on the cells known in
+ * it at the time, that is on the cells before it in the trail. Changing the
+ * clues of a line, or releasing a fixed cell, replays the trail in one pass:
+ * the line solves that may depend on the change are done again on the cells
+ * kept so far, and what they no longer settle is dropped, its lines queued.
+ * Lines no cell was dropped in are still at their fixpoint. Fixed cells
+ * stand on their own and are never dropped.
+ *
+ * Changes are only propagated when the status or the board is asked for, so
+ * that the row and column clues changed by one cell of a picture are taken
+ * in together. After a contradiction the fixpoint was never reached, and the
+ * next change starts over from the fixed cells; after running out of memory,
+ * so does the next update.
+ */
+
+struct _NonoGramSession {
+  NonoGramHints *hints;
+  NonoGramBoard *board;
+  _NonoGramWorklist worklist;
+  int *sources;        // Line that settled each cell of the trail, or -1
+  int *undone;         // First trail index of a cell dropped in each line
+  int *previous;       // Value of each cell of the trail, while replaying
+  int *values;         // Value each cell is fixed to, or NONOGRAM_UNKNOWN
+  bool contradiction;  // The last propagation failed
+  bool exhausted;      // It ran out of memory, and is to be tried again
+  bool stale;          // Changed since the last contradiction
+};
+
+static bool _fix(NonoGramSession *session, int cell) {
+  int cols_count = session->hints->cols_count;
+  return _nonogram_worklist_set(
+    &session->worklist,
+    cell / cols_count,
+    cell % cols_count,
+    session->values[cell]
+  );
+}
+
+/*
+ * Replay the trail from the first cell the change concerns, keeping a cell
+ * if nothing it depends on changed, or if its line, solved again on the
+ * cells kept before it, still settles it. Cells settled by line (-1 for
+ * none) are checked again, the cell released (-1 for none) is dropped, and
+ * so is every cell that does not hold any more. The lines of the cells
+ * dropped are queued.
+ */
+static void _retract(NonoGramSession *session, int line, int cell) {
+  _NonoGramWorklist *worklist = &session->worklist;
+  NonoGramHints *hints = session->hints;
+  NonoGramBoard *board = session->board;
+  NonoGramStats *stats = _nonogram_stats;
+  int rows_count = board->rows_count;
+  int cols_count = board->cols_count;
+  int *previous = session->previous;
+  int count = worklist->trail_count;
+  // Nothing before the first cell the change concerns depends on it
+  int index = 0;
+  while (index < count && (session->sources[index] >= 0
+      ? session->sources[index] != line
+      : worklist->trail[index] != cell)) {
+    index++;
+  }
+  for (int other = index; other < count; other++) {
+    int settled = worklist->trail[other];
+    previous[settled] = nonogram_board_get(
+      board, settled / cols_count, settled % cols_count
+    );
+  }
+  for (int other = 0; other < rows_count + cols_count; other++) {
+    session->undone[other] = INT_MAX;
+  }
+  _nonogram_worklist_undo(worklist, index);
+
+  while (index < count) {
+    // Cells settled by one line solve, or one cell fixed
+    int source = session->sources[index];
+    int end = index + 1;
+    while (source >= 0 && end < count && session->sources[end] == source) {
+      end++;
+    }
+    bool check = source >= 0 &&
+      (source == line || session->undone[source] < index);
+    int solved = 0;
+    if (check) {
+      _nonogram_board_get_line(board, source, worklist->cells);
+      solved = nonogram_line_solve(
+        _NONOGRAM_LINE_CLUES(hints, source),
+        _NONOGRAM_LINE_CLUES_COUNT(hints, source),
+        worklist->cells,
+        _NONOGRAM_BOARD_LENGTH(board, source)
+      );
+      if (stats) {
+        stats->line_solves++;
+      }
+    }
+    for (; index < end; index++) {
+      int settled = worklist->trail[index];
+      int row = settled / cols_count;
+      int col = settled % cols_count;
+      int value = previous[settled];
+      bool keep = source < 0 ? settled != cell : !check || (solved >= 0 &&
+        worklist->cells[_NONOGRAM_BOARD_IS_COL(board, source) ? row : col] ==
+          value);
+      int kept_source = source;
+      if (!keep && session->values[settled] != NONOGRAM_UNKNOWN) {
+        // Still known, as it is fixed
+        keep = true;
+        kept_source = -1;
+      }
+      if (keep) {
+        session->sources[worklist->trail_count] = kept_source;
+        worklist->trail[worklist->trail_count++] = settled;
+        nonogram_board_set(board, row, col, value);
+        continue;
+      }
+      if (session->undone[row] == INT_MAX) {
+        session->undone[row] = index;
+      }
+      if (session->undone[rows_count + col] == INT_MAX) {
+        session->undone[rows_count + col] = index;
+      }
+      _nonogram_worklist_push(worklist, row);
+      _nonogram_worklist_push(worklist, rows_count + col);
+    }
+  }
+}
+
+/* Start over from the fixed cells */
+static void _restart(NonoGramSession *session) {
+  _NonoGramWorklist *worklist = &session->worklist;
+  int rows_count = session->board->rows_count;
+  int cols_count = session->board->cols_count;
+  _nonogram_worklist_undo(worklist, 0);
+  session->contradiction = false;
+  session->exhausted = false;
+  session->stale = false;
+  for (int cell = 0; cell < rows_count * cols_count; cell++) {
+    if (session->values[cell] != NONOGRAM_UNKNOWN && !_fix(session, cell)) {
+      session->contradiction = true;
+    }
+  }
+  for (int line = 0; line < rows_count + cols_count; line++) {
+    _nonogram_worklist_push(worklist, line);
+  }
+}
+
+/* Propagate the changes made since the last call */
+static void _update(NonoGramSession *session) {
+  if (session->stale || session->exhausted) {
+    _restart(session);
+  }
+  if (!session->contradiction && session->worklist.count) {
+    int status = _nonogram_worklist_propagate(&session->worklist);
+    session->contradiction = status < 0;
+    session->exhausted = status == -2;
+  }
+}
+
+NonoGramSession *nonogram_session_create(NonoGramHints *hints) {
+  int rows_count = hints->rows_count;
+  int cols_count = hints->cols_count;
+  int lines_count = rows_count + cols_count;
+  size_t cells_count = (size_t)rows_count * cols_count;
+  NonoGramSession *session = calloc(1, sizeof(NonoGramSession));
+  if (!session) {
+    return NULL;
+  }
+  // Sessions outlive puzzles: nothing of theirs comes from an arena
+  NonoGramArena *arena = nonogram_arena_use(NULL);
+  session->hints = _nonogram_hints_new(
+    rows_count,
+    cols_count,
+    hints->offsets[lines_count]
+  );
+  session->board = nonogram_board_create(rows_count, cols_count);
+  session->sources = malloc((lines_count + 3 * cells_count) * sizeof(int));
+  bool valid = session->hints && session->board && session->sources &&
+    _nonogram_worklist_init(
+      &session->worklist, session->hints, session->board, true
+    );
+  nonogram_arena_use(arena);
+  if (!valid) {
+    if (session->hints) {
+      nonogram_hints_destroy(session->hints);
+    }
+    if (session->board) {
+      nonogram_board_destroy(session->board);
+    }
+    free(session->sources);
+    free(session);
+    return NULL;
+  }
+  memcpy(
+    session->hints->offsets,
+    hints->offsets,
+    (lines_count + 1) * sizeof(int)
+  );
+  memcpy(
+    session->hints->clues,
+    hints->clues,
+    hints->offsets[lines_count] * sizeof(int)
+  );
+  session->undone = session->sources + cells_count;
+  session->values = session->undone + lines_count;
+  session->previous = session->values + cells_count;
+  for (size_t cell = 0; cell < cells_count; cell++) {
+    session->values[cell] = NONOGRAM_UNKNOWN;
+  }
+  session->worklist.sources = session->sources;
+  for (int line = 0; line < lines_count; line++) {
+    _nonogram_worklist_push(&session->worklist, line);
+  }
+  return session;
+}
+
+void nonogram_session_destroy(NonoGramSession *session) {
+  NonoGramArena *arena = nonogram_arena_use(NULL);
+  _nonogram_worklist_free(&session->worklist);
+  nonogram_board_destroy(session->board);
+  nonogram_hints_destroy(session->hints);
+  nonogram_arena_use(arena);
+  free(session->sources);
+  free(session);
+}
+
+int nonogram_session_set_cell(
+  NonoGramSession *session,
+  int row,
+  int col,
+  int value
+) {
+  int cols_count = session->hints->cols_count;
+  if (row < 0 || row >= session->hints->rows_count ||
+      col < 0 || col >= cols_count ||
+      (value != NONOGRAM_UNKNOWN && value != NONOGRAM_EMPTY &&
+       value != NONOGRAM_FILLED)) {
+    return -1;
+  }
+  int cell = row * cols_count + col;
+  int previous = session->values[cell];
+  if (previous == value) {
+    return 0;
+  }
+  session->values[cell] = NONOGRAM_UNKNOWN;
+  if (session->contradiction) {
+    session->stale = true;
+  } else if (previous != NONOGRAM_UNKNOWN) {
+    _retract(session, -1, cell);
+  }
+  session->values[cell] = value;
+  if (!session->contradiction && value != NONOGRAM_UNKNOWN &&
+      !_fix(session, cell)) {
+    session->contradiction = true;
+  }
+  return 0;
+}
+
+static int _set_clues(NonoGramSession *session, int line, const int *clues) {
+  NonoGramHints *hints = session->hints;
+  int lines_count = hints->rows_count + hints->cols_count;
+  int length = _NONOGRAM_BOARD_LENGTH(session->board, line);
+  int count = 0;
+  while (count < length && clues[count] > 0) {
+    count++;
+  }
+  int old_count = _NONOGRAM_LINE_CLUES_COUNT(hints, line);
+  int clues_count = hints->offsets[lines_count] - old_count + count;
+  NonoGramArena *arena = nonogram_arena_use(NULL);
+  NonoGramHints *updated = _nonogram_hints_new(
+    hints->rows_count,
+    hints->cols_count,
+    clues_count
+  );
+  nonogram_arena_use(arena);
+  if (!updated) {
+    return -1;
+  }
+  int start = hints->offsets[line];
+  int end = hints->offsets[line + 1];
+  memcpy(updated->offsets, hints->offsets, (line + 1) * sizeof(int));
+  for (int next = line + 1; next <= lines_count; next++) {
+    updated->offsets[next] = hints->offsets[next] - old_count + count;
+  }
+  memcpy(updated->clues, hints->clues, start * sizeof(int));
+  memcpy(updated->clues + start, clues, count * sizeof(int));
+  memcpy(
+    updated->clues + start + count,
+    hints->clues + end,
+    (hints->offsets[lines_count] - end) * sizeof(int)
+  );
+
+  session->hints = updated;
+  _nonogram_worklist_set_clues(&session->worklist, updated, line);
+  if (session->contradiction) {
+    session->stale = true;
+  } else {
+    _retract(session, line, -1);
+  }
+  arena = nonogram_arena_use(NULL);
+  nonogram_hints_destroy(hints);
+  nonogram_arena_use(arena);
+  return 0;
+}
+
+int nonogram_session_set_row_clues(
+  NonoGramSession *session,
+  int row,
+  const int *clues
+) {
+  if (row < 0 || row >= session->hints->rows_count) {
+    return -1;
+  }
+  return _set_clues(session, row, clues);
+}
+
+int nonogram_session_set_col_clues(
+  NonoGramSession *session,
+  int col,
+  const int *clues
+) {
+  if (col < 0 || col >= session->hints->cols_count) {
+    return -1;
+  }
+  return _set_clues(session, session->hints->rows_count + col, clues);
+}
+
+int nonogram_session_get_status(NonoGramSession *session) {
+  _update(session);
+  if (session->contradiction) {
+    return session->exhausted ? -2 : -1;
+  }
+  return nonogram_board_get_unknown_count(session->board);
+}
+
+NonoGramHints *nonogram_session_get_hints(NonoGramSession *session) {
+  return session->hints;
+}
+
+NonoGramBoard *nonogram_session_get_board(NonoGramSession *session) {
+  _update(session);
+  return session->board;
+}
@@ -0,0 +1,148 @@
+// Copyright © Christophe Demko <christophe.demko@univ-lr.fr>, 2024
+// Licensed under the BSD-3 License. See the LICENSE file for details.
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+
+#include "./nonogram.h"
+#include "./nonogram.inc"
+
+static void check_same_board(NonoGramBoard *board, NonoGramBoard *expected) {
+  assert(board);
+  assert(board->rows_count == expected->rows_count);
+  assert(board->cols_count == expected->cols_count);
+  for (int row = 0; row < board->rows_count; row++) {
+    for (int col = 0; col < board->cols_count; col++) {
+      assert(nonogram_board_get(board, row, col) ==
+             nonogram_board_get(expected, row, col));
+    }
+  }
+}
+
+int main(void) {
+  // Puzzles wider than a word, with and without boards and solutions
+  srand(2024);
+  NonoGramBoard *solutions[12];
+  NonoGramBoard *boards[12];
+  NonoGramHints *hints[12];
+  for (int puzzle = 0; puzzle < 12; puzzle++) {
+    int rows_count = 1 + rand() % 20;
+    int cols_count = 1 + rand() % 90;
+    solutions[puzzle] = nonogram_board_create(rows_count, cols_count);
+    boards[puzzle] = nonogram_board_create(rows_count, cols_count);
+    for (int row = 0; row < rows_count; row++) {
+      for (int col = 0; col < cols_count; col++) {
+        int value = rand() % 2;
+        nonogram_board_set(solutions[puzzle], row, col, value);
+        if (rand() % 4 == 0) {
+          nonogram_board_set(boards[puzzle], row, col, value);
+        }
+      }
+    }
+    hints[puzzle] = nonogram_hints_create_from_board(solutions[puzzle]);
+  }
+
+  char path[] = "/tmp/test-archive-XXXXXX";
+  int fd = mkstemp(path);
+  assert(fd >= 0);
+  for (int in_place = 0; in_place < 2; in_place++) {
+    FILE *file = fopen(path, "wb");
+    NonoGramArchiveWriter *writer = nonogram_archive_writer_create(
+      file, in_place
+    );
+    for (int puzzle = 0; puzzle < 12; puzzle++) {
+      assert(nonogram_archive_writer_add(
+        writer,
+        hints[puzzle],
+        puzzle % 3 == 1 ? boards[puzzle] : NULL,
+        puzzle % 2 == 1 ? solutions[puzzle] : NULL
+      ));
+    }
+    // Dimensions must match
+    NonoGramBoard *other = nonogram_board_create(
+      hints[0]->rows_count + 1, hints[0]->cols_count
+    );
+    assert(!nonogram_archive_writer_add(writer, hints[0], other, NULL));
+    nonogram_board_destroy(other);
+    assert(nonogram_archive_writer_close(writer));
+    fclose(file);
+
+    NonoGramArchive *archive = nonogram_archive_open(path);
+    assert(archive);
+    assert(nonogram_archive_get_count(archive) == 12);
+    // From last to first, as any worker would
+    for (int puzzle = 11; puzzle >= 0; puzzle--) {
+      NonoGramHints *read_hints;
+      NonoGramBoard *board;
+      NonoGramBoard *solution;
+      assert(nonogram_archive_get(
+        archive, puzzle, &read_hints, &board, &solution
+      ));
+      int lines_count = read_hints->rows_count + read_hints->cols_count;
+      assert(read_hints->rows_count == hints[puzzle]->rows_count);
+      assert(memcmp(read_hints->offsets, hints[puzzle]->offsets,
+                    (lines_count + 1) * sizeof(int)) == 0);
+      assert(memcmp(read_hints->clues, hints[puzzle]->clues,
+                    read_hints->offsets[lines_count] * sizeof(int)) == 0);
+      if (puzzle % 3 == 1) {
+        check_same_board(board, boards[puzzle]);
+        nonogram_board_destroy(board);
+      } else {
+        assert(board == NULL);
+      }
+      if (puzzle % 2 == 1) {
+        check_same_board(solution, solutions[puzzle]);
+        assert(nonogram_hints_check(read_hints, solution));
+        nonogram_board_destroy(solution);
+      } else {
+        assert(solution == NULL);
+      }
+      nonogram_hints_destroy(read_hints);
+      // Parts are optional
+      assert(nonogram_archive_get(archive, puzzle, NULL, NULL, &solution));
+      if (solution) {
+        nonogram_board_destroy(solution);
+      }
+    }
+    assert(!nonogram_archive_get(archive, 12, NULL, NULL, NULL));
+    assert(!nonogram_archive_get(archive, -1, NULL, NULL, NULL));
+    nonogram_archive_close(archive);
+  }
+
+  // Truncated archives are rejected
+  assert(truncate(path, 100) == 0);
+  assert(nonogram_archive_open(path) == NULL);
+
+  // So are indexes out of the file, even when their end wraps around to the
+  // trailer
+  uint64_t indexes[2] = {UINT64_MAX - 15, 8};
+  for (int crafted = 0; crafted < 2; crafted++) {
+    unsigned char bytes[24] = {'N', 'G', 'R', 'A', 1};
+    for (int byte = 0; byte < 8; byte++) {
+      bytes[8 + byte] = (unsigned char)(indexes[crafted] >> (8 * byte));
+    }
+    bytes[16] = 1;
+    memcpy(bytes + 20, "NGRA", 4);
+    FILE *file = fopen(path, "wb");
+    assert(fwrite(bytes, 1, sizeof bytes, file) == sizeof bytes);
+    fclose(file);
+    assert(nonogram_archive_open(path) == NULL);
+  }
+  close(fd);
+  unlink(path);
+  assert(nonogram_archive_open(path) == NULL);
+
+  for (int puzzle = 0; puzzle < 12; puzzle++) {
+    nonogram_hints_destroy(hints[puzzle]);
+    nonogram_board_destroy(boards[puzzle]);
+    nonogram_board_destroy(solutions[puzzle]);
+  }
+  return EXIT_SUCCESS;
+}
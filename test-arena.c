@@ -0,0 +1,68 @@
+// Copyright © Christophe Demko <christophe.demko@univ-lr.fr>, 2024
+// Licensed under the BSD-3 License. See the LICENSE file for details.
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+
+#include "./nonogram.h"
+#include "./nonogram.inc"
+
+int main(void) {
+  NonoGramArena *arena = nonogram_arena_create(1024);
+  assert(arena);
+  assert(nonogram_arena_get_size(arena) == 1024);
+  assert(nonogram_arena_use(arena) == NULL);
+
+  // The last allocation is given back at once, others wait for a reset
+  char *first = _nonogram_alloc(10);
+  char *second = _nonogram_alloc(10);
+  assert(first && second && first != second);
+  assert((uintptr_t)second % _Alignof(max_align_t) == 0);
+  _nonogram_free(second);
+  assert(_nonogram_alloc(10) == second);
+  _nonogram_free(first);
+  assert(_nonogram_alloc(10) != first);
+
+  // Larger blocks add chunks, which resets keep
+  char *large = _nonogram_alloc(4096);
+  assert(large);
+  size_t size = nonogram_arena_get_size(arena);
+  assert(size >= 1024 + 4096);
+  nonogram_arena_reset(arena);
+  assert(_nonogram_alloc(10) == first);
+  assert(_nonogram_alloc(4096) == large);
+  assert(nonogram_arena_get_size(arena) == size);
+  nonogram_arena_reset(arena);
+
+  // Puzzles solved in the arena, the second one in the memory of the first
+  NonoGramHints *hints = nonogram_hints_parse(
+    "{\"rows\":[[2,1],[1,1],[],[1,1],[2,2]],"
+    "\"cols\":[[2,2],[1,1],[],[1,1],[1,2]]}"
+  );
+  for (int round = 0; round < 2; round++) {
+    NonoGramBoard *board = nonogram_board_create(5, 5);
+    assert(nonogram_hints_search(hints, board) == 1);
+    assert(nonogram_hints_check(hints, board));
+    assert(nonogram_board_get_unknown_count(board) == 0);
+    nonogram_board_destroy(board);
+    if (round == 0) {
+      size = nonogram_arena_get_size(arena);
+    }
+  }
+  assert(nonogram_arena_get_size(arena) == size);
+  nonogram_hints_destroy(hints);
+  nonogram_arena_reset(arena);
+
+  // Memory from malloc is still released once the arena is gone
+  assert(nonogram_arena_use(NULL) == arena);
+  NonoGramBoard *board = nonogram_board_create(5, 5);
+  assert(board);
+  nonogram_board_destroy(board);
+  nonogram_arena_destroy(arena);
+  return EXIT_SUCCESS;
+}
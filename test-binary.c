@@ -0,0 +1,110 @@
+// Copyright © Christophe Demko <christophe.demko@univ-lr.fr>, 2024
+// Licensed under the BSD-3 License. See the LICENSE file for details.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+
+#include "./nonogram.h"
+#include "./nonogram.inc"
+
+static void check_same(NonoGramHints *hints, NonoGramHints *expected) {
+  assert(hints);
+  assert(hints->rows_count == expected->rows_count);
+  assert(hints->cols_count == expected->cols_count);
+  int lines_count = hints->rows_count + hints->cols_count;
+  assert(memcmp(hints->offsets, expected->offsets,
+                (lines_count + 1) * sizeof(int)) == 0);
+  assert(memcmp(hints->clues, expected->clues,
+                hints->offsets[lines_count] * sizeof(int)) == 0);
+}
+
+int main(void) {
+  NonoGramHints *expected = nonogram_hints_parse(
+    "{\"rows\":[[2,1],[1,1],[],[1,1],[2,2]],"
+    "\"cols\":[[2,2],[1,1],[],[1,1],[1,2]]}"
+  );
+  // 20 bytes of header, 11 offsets and 16 clues
+  assert(nonogram_hints_pack(expected, 0, NULL, 0) == 20 + 27);
+  assert(nonogram_hints_pack(expected, 1, NULL, 0) == 20 + 4 * 27);
+
+  unsigned char buffer[512];
+  for (int in_place = 0; in_place < 2; in_place++) {
+    size_t size = nonogram_hints_pack(expected, in_place, buffer, sizeof buffer);
+    assert(size <= sizeof buffer);
+    NonoGramHints *hints = nonogram_hints_unpack(buffer, size);
+    check_same(hints, expected);
+    assert(hints->mapped == NULL);
+    nonogram_hints_destroy(hints);
+    // Truncated data is rejected
+    assert(nonogram_hints_unpack(buffer, size - 1) == NULL);
+  }
+
+  // Malformed data: magic, version, offsets and clues are checked
+  size_t size = nonogram_hints_pack(expected, 0, buffer, sizeof buffer);
+  buffer[0] = 'X';
+  assert(nonogram_hints_unpack(buffer, size) == NULL);
+  buffer[0] = 'N';
+  buffer[4] = 2;
+  assert(nonogram_hints_unpack(buffer, size) == NULL);
+  buffer[4] = 1;
+  buffer[7] = 3;
+  assert(nonogram_hints_unpack(buffer, size) == NULL);
+  buffer[7] = 1;
+  buffer[20 + 3] = 9;
+  assert(nonogram_hints_unpack(buffer, size) == NULL);
+  buffer[20 + 3] = 4;
+  buffer[20 + 11] = 0;
+  assert(nonogram_hints_unpack(buffer, size) == NULL);
+  buffer[20 + 11] = 6;
+  assert(nonogram_hints_unpack(buffer, size) == NULL);
+  buffer[20 + 11] = 2;
+  NonoGramHints *hints = nonogram_hints_unpack(buffer, size);
+  check_same(hints, expected);
+  nonogram_hints_destroy(hints);
+
+  // Each table takes its own width: clues too large for a byte take two,
+  // offsets that fit in a byte take one
+  char json[2048] = "{\"rows\":[[300]],\"cols\":[[]";
+  for (int col = 1; col < 300; col++) {
+    strcat(json, ",[]");
+  }
+  strcat(json, "]}");
+  NonoGramHints *wide = nonogram_hints_parse(json);
+  size = nonogram_hints_pack(wide, 0, buffer, sizeof buffer);
+  assert(size == 20 + 302 + 2);
+  hints = nonogram_hints_unpack(buffer, size);
+  check_same(hints, wide);
+  nonogram_hints_destroy(hints);
+  nonogram_hints_destroy(wide);
+
+  // Mapped files, used in place or widened
+  char path[] = "/tmp/test-binary-XXXXXX";
+  int fd = mkstemp(path);
+  assert(fd >= 0);
+  for (int in_place = 0; in_place < 2; in_place++) {
+    size = nonogram_hints_pack(expected, in_place, buffer, sizeof buffer);
+    assert(pwrite(fd, buffer, size, 0) == (ssize_t)size);
+    assert(ftruncate(fd, size) == 0);
+    hints = nonogram_hints_map(path);
+    check_same(hints, expected);
+    assert((hints->mapped != NULL) == in_place);
+    NonoGramBoard *board = nonogram_board_create(5, 5);
+    assert(nonogram_hints_search(hints, board) == 1);
+    nonogram_board_destroy(board);
+    nonogram_hints_destroy(hints);
+  }
+  assert(ftruncate(fd, 10) == 0);
+  assert(nonogram_hints_map(path) == NULL);
+  close(fd);
+  unlink(path);
+  assert(nonogram_hints_map(path) == NULL);
+
+  nonogram_hints_destroy(expected);
+  return EXIT_SUCCESS;
+}
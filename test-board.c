@@ -0,0 +1,209 @@
+// Copyright © Christophe Demko <christophe.demko@univ-lr.fr>, 2024
+// Licensed under the BSD-3 License. See the LICENSE file for details.
+#include <stdlib.h>
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+
+#include "./nonogram.h"
+#include "./nonogram.inc"
+
+int main(void) {
+  assert(nonogram_board_create(0, 0) == NULL);
+
+  // Wider and taller than a word to cross word boundaries
+  int rows_count = 70;
+  int cols_count = 130;
+  NonoGramBoard *board = nonogram_board_create(rows_count, cols_count);
+  assert(board);
+  assert(nonogram_board_get_rows_count(board) == rows_count);
+  assert(nonogram_board_get_cols_count(board) == cols_count);
+  assert(board->row_words == 3);
+  assert(board->col_words == 2);
+  assert(nonogram_board_get_unknown_count(board) == rows_count * cols_count);
+  assert(nonogram_board_get(board, 69, 129) == NONOGRAM_UNKNOWN);
+
+  nonogram_board_set(board, 69, 129, NONOGRAM_FILLED);
+  nonogram_board_set(board, 0, 64, NONOGRAM_EMPTY);
+  assert(nonogram_board_get(board, 69, 129) == NONOGRAM_FILLED);
+  assert(nonogram_board_get(board, 0, 64) == NONOGRAM_EMPTY);
+  assert(board->filled[69 * 3 + 2] == (uint64_t)1 << 1);
+  assert(board->filled_t[129 * 2 + 1] == (uint64_t)1 << 5);
+  assert(board->empty[1] == 1);
+  assert(board->empty_t[64 * 2] == 1);
+  assert(nonogram_board_get_unknown_count(board) ==
+         rows_count * cols_count - 2);
+
+  nonogram_board_set(board, 69, 129, NONOGRAM_EMPTY);
+  assert(nonogram_board_get(board, 69, 129) == NONOGRAM_EMPTY);
+  assert(board->filled[69 * 3 + 2] == 0);
+  assert(board->filled_t[129 * 2 + 1] == 0);
+  nonogram_board_set(board, 69, 129, NONOGRAM_UNKNOWN);
+  assert(nonogram_board_get(board, 69, 129) == NONOGRAM_UNKNOWN);
+  assert(board->empty[69 * 3 + 2] == 0);
+  assert(board->empty_t[129 * 2 + 1] == 0);
+  nonogram_board_destroy(board);
+
+  // Runs crossing word boundaries
+  board = nonogram_board_create(2, cols_count);
+  for (int col = 60; col < 70; col++) {
+    nonogram_board_set(board, 0, col, NONOGRAM_FILLED);
+  }
+  nonogram_board_set(board, 0, 0, NONOGRAM_FILLED);
+  nonogram_board_set(board, 0, 127, NONOGRAM_FILLED);
+  nonogram_board_set(board, 0, 128, NONOGRAM_FILLED);
+  nonogram_board_set(board, 0, 129, NONOGRAM_FILLED);
+  nonogram_board_set(board, 1, 64, NONOGRAM_FILLED);
+  NonoGramHints *hints = nonogram_hints_create_from_board(board);
+  assert(nonogram_hints_get_row_value(hints, 0, 0) == 1);
+  assert(nonogram_hints_get_row_value(hints, 0, 1) == 10);
+  assert(nonogram_hints_get_row_value(hints, 0, 2) == 3);
+  assert(nonogram_hints_get_row_value(hints, 0, 3) == 0);
+  assert(nonogram_hints_get_row_value(hints, 1, 0) == 1);
+  assert(nonogram_hints_get_row_value(hints, 1, 1) == 0);
+  assert(nonogram_hints_get_col_value(hints, 0, 0) == 1);
+  assert(nonogram_hints_get_col_value(hints, 1, 0) == 0);
+  assert(nonogram_hints_get_col_value(hints, 64, 0) == 2);
+  assert(nonogram_hints_get_col_value(hints, 64, 1) == 0);
+  assert(nonogram_hints_check(hints, board));
+  nonogram_hints_destroy(hints);
+  nonogram_board_destroy(board);
+
+  // PBM-style packed rows: 70 columns take 9 bytes, the last one padded
+  unsigned char bitmap[2 * 9] = {0};
+  bitmap[0] = 0x80;      // Column 0
+  bitmap[8] = 0x20;      // Column 66
+  bitmap[9 + 7] = 0x01;  // Column 63
+  bitmap[9 + 8] = 0xff;  // Columns 64 to 69 and padding
+  board = nonogram_board_create_from_bitmap(bitmap, 2, 70);
+  assert(board);
+  assert(board->filled[0] == 1);
+  assert(board->filled[1] == (uint64_t)1 << 2);
+  assert(board->filled[2] == (uint64_t)1 << 63);
+  assert(board->filled[3] == 0x3f);
+  assert(nonogram_board_get(board, 0, 0) == NONOGRAM_FILLED);
+  assert(nonogram_board_get(board, 0, 1) == NONOGRAM_UNKNOWN);
+  assert(nonogram_board_get(board, 0, 66) == NONOGRAM_FILLED);
+  assert(nonogram_board_get(board, 1, 62) == NONOGRAM_UNKNOWN);
+  assert(nonogram_board_get(board, 1, 63) == NONOGRAM_FILLED);
+  assert(nonogram_board_get(board, 1, 69) == NONOGRAM_FILLED);
+  assert(board->filled_t[0] == 1);
+  assert(board->filled_t[64] == 2);
+  assert(board->filled_t[66] == 3);
+  assert(board->filled_t[63] == 2);
+  assert(board->filled_t[69] == 2);
+  assert(nonogram_board_get_unknown_count(board) == 2 * 70 - 9);
+  nonogram_board_destroy(board);
+
+  int **cells = malloc(2 * sizeof(int *));
+  for (int row = 0; row < 2; row++) {
+    cells[row] = malloc(2 * sizeof(int));
+  }
+  cells[0][0] = NONOGRAM_FILLED;
+  cells[0][1] = NONOGRAM_EMPTY;
+  cells[1][0] = NONOGRAM_UNKNOWN;
+  cells[1][1] = NONOGRAM_FILLED;
+  board = nonogram_board_create_from_array(cells, 2, 2);
+  for (int row = 0; row < 2; row++) {
+    for (int col = 0; col < 2; col++) {
+      assert(nonogram_board_get(board, row, col) == cells[row][col]);
+    }
+  }
+  assert(nonogram_board_get_unknown_count(board) == 1);
+  nonogram_board_destroy(board);
+  for (int row = 0; row < 2; row++) {
+    free(cells[row]);
+  }
+  free(cells);
+
+  // Every SIMD level packs, unpacks and finds runs as a cell by cell loop
+  srand(2024);
+  for (int level = _NONOGRAM_SIMD_SCALAR; level <= _NONOGRAM_SIMD_AVX2; level++) {
+    int previous = _nonogram_simd_select(level);
+    for (int round = 0; round < 200; round++) {
+      int length = 1 + rand() % 300;
+      int line[300];
+      unsigned char bytes[38];
+      uint64_t packed[5];
+      uint64_t unpacked[5];
+      // From sparse to dense lines, for runs across word boundaries
+      for (int cell = 0; cell < length; cell++) {
+        line[cell] = rand() % 8 < round % 9 ? NONOGRAM_FILLED : rand() % 2 - 1;
+      }
+      for (int byte = 0; byte < (length + 7) / 8; byte++) {
+        bytes[byte] = 0;
+        for (int bit = 0; bit < 8; bit++) {
+          int cell = 8 * byte + bit;
+          // Padding bits are set too and must be ignored
+          if (cell >= length || line[cell] == NONOGRAM_FILLED) {
+            bytes[byte] |= 0x80 >> bit;
+          }
+        }
+      }
+      _nonogram_pack_line(line, length, packed);
+      _nonogram_bitmap_row(bytes, length, unpacked);
+      for (int word = 0; word < _NONOGRAM_WORDS(length); word++) {
+        assert(packed[word] == unpacked[word]);
+      }
+      for (int cell = 0; cell < length; cell++) {
+        assert(((packed[cell / 64] >> (cell % 64)) & 1) ==
+               (line[cell] == NONOGRAM_FILLED));
+      }
+
+      int runs[150];
+      int expected[150];
+      int count = 0;
+      for (int cell = 0; cell < length; cell++) {
+        if (line[cell] == NONOGRAM_FILLED) {
+          if (cell == 0 || line[cell - 1] != NONOGRAM_FILLED) {
+            expected[count++] = 0;
+          }
+          expected[count - 1]++;
+        }
+      }
+      assert(_nonogram_board_runs(packed, length, runs) == count);
+      assert(_nonogram_board_runs_count(packed, length) == count);
+      for (int run = 0; run < count; run++) {
+        assert(runs[run] == expected[run]);
+      }
+    }
+    _nonogram_simd_select(previous);
+  }
+
+  // Block transposes match a bit by bit one, partial blocks included
+  for (int round = 0; round < 20; round++) {
+    int rows = 1 + rand() % 200;
+    int cols = 1 + rand() % 200;
+    int source_words = _NONOGRAM_WORDS(cols);
+    int target_words = _NONOGRAM_WORDS(rows);
+    uint64_t *source = malloc(rows * source_words * sizeof(uint64_t));
+    uint64_t *target = malloc(cols * target_words * sizeof(uint64_t));
+    for (int word = 0; word < rows * source_words; word++) {
+      source[word] = (uint64_t)rand() << 40 ^ (uint64_t)rand() << 20 ^ rand();
+    }
+    for (int row = 0; row < rows; row++) {
+      if (cols % 64) {
+        source[(row + 1) * source_words - 1] &= _NONOGRAM_BIT(cols) - 1;
+      }
+    }
+    _nonogram_transpose(source, rows, cols, source_words, target, target_words);
+    for (int row = 0; row < rows; row++) {
+      for (int col = 0; col < cols; col++) {
+        assert(((source[row * source_words + col / 64] >> (col % 64)) & 1) ==
+               ((target[col * target_words + row / 64] >> (row % 64)) & 1));
+      }
+    }
+    // Rows past the last one read as empty
+    for (int col = 0; col < cols; col++) {
+      if (rows % 64) {
+        assert(!(target[(col + 1) * target_words - 1] >> (rows % 64)));
+      }
+    }
+    free(source);
+    free(target);
+  }
+
+  return EXIT_SUCCESS;
+}
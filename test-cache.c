@@ -0,0 +1,124 @@
+// Copyright © Christophe Demko <christophe.demko@univ-lr.fr>, 2024
+// Licensed under the BSD-3 License. See the LICENSE file for details.
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+
+#include "./nonogram.h"
+
+#define ROWS 7
+#define COLS 5
+
+/* Rotate image a quarter turn, or mirror it left to right */
+static NonoGramBoard *turn(NonoGramBoard *image, int mirror) {
+  int rows_count = nonogram_board_get_rows_count(image);
+  int cols_count = nonogram_board_get_cols_count(image);
+  NonoGramBoard *turned = mirror
+    ? nonogram_board_create(rows_count, cols_count)
+    : nonogram_board_create(cols_count, rows_count);
+  for (int row = 0; row < rows_count; row++) {
+    for (int col = 0; col < cols_count; col++) {
+      int value = nonogram_board_get(image, row, col);
+      if (mirror) {
+        nonogram_board_set(turned, row, cols_count - 1 - col, value);
+      } else {
+        nonogram_board_set(turned, col, rows_count - 1 - row, value);
+      }
+    }
+  }
+  return turned;
+}
+
+/* The cache must give a solution of each image of the puzzle */
+static void check(NonoGramCache *cache, NonoGramBoard *image, uint64_t hash) {
+  NonoGramHints *hints = nonogram_hints_create_from_board(image);
+  assert(nonogram_hints_hash(hints) == hash);
+  NonoGramBoard *solution = nonogram_cache_get(cache, hints);
+  assert(solution);
+  assert(nonogram_board_get_rows_count(solution) ==
+         nonogram_board_get_rows_count(image));
+  assert(nonogram_board_get_unknown_count(solution) == 0);
+  assert(nonogram_hints_check(hints, solution));
+  nonogram_board_destroy(solution);
+  nonogram_hints_destroy(hints);
+}
+
+int main(void) {
+  char path[] = "/tmp/test-cache-XXXXXX";
+  assert(mkdtemp(path));
+  NonoGramCache *cache = nonogram_cache_open(path);
+  assert(cache);
+
+  int cells[ROWS][COLS] = {
+    {1, 1, 0, 0, 0},
+    {0, 1, 1, 0, 1},
+    {1, 1, 1, 1, 0},
+    {0, 0, 0, 1, 0},
+    {1, 0, 1, 1, 1},
+    {0, 1, 1, 0, 0},
+    {1, 1, 0, 0, 1},
+  };
+  NonoGramBoard *image = nonogram_board_create(ROWS, COLS);
+  for (int row = 0; row < ROWS; row++) {
+    for (int col = 0; col < COLS; col++) {
+      nonogram_board_set(image, row, col, cells[row][col]);
+    }
+  }
+  NonoGramHints *hints = nonogram_hints_create_from_board(image);
+  uint64_t hash = nonogram_hints_hash(hints);
+  assert(!nonogram_cache_get(cache, hints));
+
+  // Only complete solutions are stored
+  NonoGramBoard *board = nonogram_board_create(ROWS, COLS);
+  assert(!nonogram_cache_put(cache, hints, board));
+  assert(nonogram_hints_search(hints, board) == 1);
+  assert(nonogram_cache_put(cache, hints, board));
+  nonogram_board_destroy(board);
+  nonogram_hints_destroy(hints);
+
+  // Every rotation, with or without mirroring, finds the solution
+  for (int mirror = 0; mirror < 2; mirror++) {
+    for (int quarter = 0; quarter < 4; quarter++) {
+      check(cache, image, hash);
+      NonoGramBoard *turned = turn(image, 0);
+      nonogram_board_destroy(image);
+      image = turned;
+    }
+    NonoGramBoard *mirrored = turn(image, 1);
+    nonogram_board_destroy(image);
+    image = mirrored;
+  }
+
+  // Another puzzle misses
+  nonogram_board_set(image, 0, 0, !nonogram_board_get(image, 0, 0));
+  hints = nonogram_hints_create_from_board(image);
+  assert(nonogram_hints_hash(hints) != hash);
+  assert(!nonogram_cache_get(cache, hints));
+  nonogram_hints_destroy(hints);
+  nonogram_board_destroy(image);
+  nonogram_cache_close(cache);
+
+  // A single entry was written
+  DIR *directory = opendir(path);
+  assert(directory);
+  int count = 0;
+  struct dirent *entry;
+  char name[sizeof path + 256];
+  while ((entry = readdir(directory)) != NULL) {
+    if (entry->d_name[0] != '.') {
+      snprintf(name, sizeof name, "%s/%s", path, entry->d_name);
+      assert(!unlink(name));
+      count++;
+    }
+  }
+  closedir(directory);
+  assert(count == 1);
+  assert(!rmdir(path));
+  return EXIT_SUCCESS;
+}
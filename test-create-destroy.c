@@ -31,41 +31,74 @@ int main(void) {
   board[4][4] = 1;
   NonoGramHints *hints = nonogram_hints_create(board, rows_count, cols_count);
   assert(hints);
-  assert(hints->rows);
-  assert(hints->cols);
+  assert(hints->offsets);
+  assert(hints->clues);
   assert(hints->rows_count == rows_count);
   assert(hints->cols_count == cols_count);
-  assert(hints->rows[0][0] == 2);
-  assert(hints->rows[0][1] == 1);
-  assert(hints->rows[0][2] == 0);
-  assert(hints->rows[1][0] == 1);
-  assert(hints->rows[1][1] == 1);
-  assert(hints->rows[1][2] == 0);
-  assert(hints->rows[2][0] == 0);
-  assert(hints->rows[3][0] == 1);
-  assert(hints->rows[3][1] == 1);
-  assert(hints->rows[3][2] == 0);
-  assert(hints->rows[4][0] == 2);
-  assert(hints->rows[4][1] == 2);
-  assert(hints->rows[4][2] == 0);
-  assert(hints->cols[0][0] == 2);
-  assert(hints->cols[0][1] == 2);
-  assert(hints->cols[0][2] == 0);
-  assert(hints->cols[1][0] == 1);
-  assert(hints->cols[1][1] == 1);
-  assert(hints->cols[1][2] == 0);
-  assert(hints->cols[2][0] == 0);
-  assert(hints->cols[3][0] == 1);
-  assert(hints->cols[3][1] == 1);
-  assert(hints->cols[3][2] == 0);
-  assert(hints->cols[4][0] == 1);
-  assert(hints->cols[4][1] == 2);
-  assert(hints->cols[4][2] == 0);
+  // Rows
+  assert(hints->offsets[0] == 0);
+  assert(hints->offsets[1] == 2);
+  assert(hints->offsets[2] == 4);
+  assert(hints->offsets[3] == 4);
+  assert(hints->offsets[4] == 6);
+  assert(hints->offsets[5] == 8);
+  assert(hints->clues[0] == 2);
+  assert(hints->clues[1] == 1);
+  assert(hints->clues[2] == 1);
+  assert(hints->clues[3] == 1);
+  assert(hints->clues[4] == 1);
+  assert(hints->clues[5] == 1);
+  assert(hints->clues[6] == 2);
+  assert(hints->clues[7] == 2);
+  // Columns
+  assert(hints->offsets[6] == 10);
+  assert(hints->offsets[7] == 12);
+  assert(hints->offsets[8] == 12);
+  assert(hints->offsets[9] == 14);
+  assert(hints->offsets[10] == 16);
+  assert(hints->clues[8] == 2);
+  assert(hints->clues[9] == 2);
+  assert(hints->clues[10] == 1);
+  assert(hints->clues[11] == 1);
+  assert(hints->clues[12] == 1);
+  assert(hints->clues[13] == 1);
+  assert(hints->clues[14] == 1);
+  assert(hints->clues[15] == 2);
   nonogram_hints_destroy(hints);
   for (int row = 0; row < rows_count; row++) {
     free(board[row]);
   }
   free(board);
 
+  // Hints read off a bitmap match those of the board it fills
+  srand(2024);
+  for (int round = 0; round < 100; round++) {
+    rows_count = 1 + rand() % 150;
+    cols_count = 1 + rand() % 150;
+    int stride = (cols_count + 7) / 8;
+    unsigned char *bitmap = malloc((size_t)rows_count * stride);
+    for (int byte = 0; byte < rows_count * stride; byte++) {
+      bitmap[byte] = rand() % 256;
+    }
+    NonoGramBoard *filled = nonogram_board_create_from_bitmap(
+      bitmap, rows_count, cols_count
+    );
+    NonoGramHints *expected = nonogram_hints_create_from_board(filled);
+    hints = nonogram_hints_create_from_bitmap(bitmap, rows_count, cols_count);
+    assert(hints);
+    int lines_count = rows_count + cols_count;
+    for (int line = 0; line <= lines_count; line++) {
+      assert(hints->offsets[line] == expected->offsets[line]);
+    }
+    for (int clue = 0; clue < expected->offsets[lines_count]; clue++) {
+      assert(hints->clues[clue] == expected->clues[clue]);
+    }
+    nonogram_hints_destroy(hints);
+    nonogram_hints_destroy(expected);
+    nonogram_board_destroy(filled);
+    free(bitmap);
+  }
+  assert(nonogram_hints_create_from_bitmap(NULL, 0, 5) == NULL);
+
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,216 @@
+// Copyright © Christophe Demko <christophe.demko@univ-lr.fr>, 2024
+// Licensed under the BSD-3 License. See the LICENSE file for details.
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+
+#include "./nonogram.h"
+#include "./nonogram.inc"
+
+#define U NONOGRAM_UNKNOWN
+#define E NONOGRAM_EMPTY
+#define F NONOGRAM_FILLED
+
+static void check_line(
+  const int *clues,
+  int clues_count,
+  const int *input,
+  const int *expected,
+  int length,
+  int settled
+) {
+  int line[16];
+  memcpy(line, input, length * sizeof(int));
+  assert(nonogram_line_solve(clues, clues_count, line, length) == settled);
+  if (settled >= 0) {
+    assert(memcmp(line, expected, length * sizeof(int)) == 0);
+  }
+}
+
+int main(void) {
+  {
+    // Overlap on a blank line
+    int clues[] = {3, 1};
+    int input[] = {U, U, U, U, U, U};
+    int expected[] = {U, F, F, U, U, U};
+    check_line(clues, 2, input, expected, 6, 2);
+  }
+  {
+    // Tight blank line
+    int clues[] = {2, 2};
+    int input[] = {U, U, U, U, U};
+    int expected[] = {F, F, E, F, F};
+    check_line(clues, 2, input, expected, 5, 5);
+  }
+  {
+    // No clue
+    int input[] = {U, U, U};
+    int expected[] = {E, E, E};
+    check_line(NULL, 0, input, expected, 3, 3);
+  }
+  {
+    // Clues too long
+    int clues[] = {3, 2};
+    int input[] = {U, U, U, U, U};
+    check_line(clues, 2, input, NULL, 5, -1);
+  }
+  {
+    // Clues whose sum overflows an int
+    int clues[] = {0x7fffffff, 0x7fffffff, 3};
+    int input[] = {U, U, U};
+    int known[] = {U, F, U};
+    check_line(clues, 3, input, NULL, 3, -1);
+    check_line(clues, 3, known, NULL, 3, -1);
+  }
+  {
+    // A filled cell anchors the clue
+    int clues[] = {2};
+    int input[] = {U, U, U, F, U, U};
+    int expected[] = {E, E, U, F, U, E};
+    check_line(clues, 1, input, expected, 6, 3);
+  }
+  {
+    // An empty cell splits the line
+    int clues[] = {3};
+    int input[] = {U, U, E, U, U, U};
+    int expected[] = {E, E, E, F, F, F};
+    check_line(clues, 1, input, expected, 6, 5);
+  }
+  {
+    // Deductions needing the full dynamic programming
+    int clues[] = {1, 2};
+    int input[] = {U, U, F, U, U, U, E, U};
+    int expected[] = {U, E, F, U, U, U, E, E};
+    check_line(clues, 2, input, expected, 8, 2);
+  }
+  {
+    // Contradiction with known cells
+    int clues[] = {1};
+    int input[] = {F, E, F};
+    check_line(clues, 1, input, NULL, 3, -1);
+  }
+
+  int rows_count = 4;
+  int cols_count = 3;
+  int **board = malloc(rows_count * sizeof(int *));
+  for (int row = 0; row < rows_count; row++) {
+    board[row] = calloc(cols_count, sizeof(int));
+  }
+  /**
+   * Board and hints:
+   *        1 2
+   *      1 1 1
+   *     +-----
+   * 1 1 |■   ■
+   *   2 |  ■ ■
+   *     |
+   *   2 |  ■ ■
+   */
+  board[0][0] = 1;
+  board[0][2] = 1;
+  board[1][1] = 1;
+  board[1][2] = 1;
+  board[3][1] = 1;
+  board[3][2] = 1;
+  NonoGramHints *hints = nonogram_hints_create(board, rows_count, cols_count);
+
+  NonoGramBoard *solution = nonogram_board_create(rows_count, cols_count);
+  assert(nonogram_hints_solve(hints, solution) == 0);
+  for (int row = 0; row < rows_count; row++) {
+    for (int col = 0; col < cols_count; col++) {
+      assert(nonogram_board_get(solution, row, col) == board[row][col]);
+    }
+  }
+  nonogram_board_destroy(solution);
+
+  // A filled cell outside the solution is detected
+  solution = nonogram_board_create(rows_count, cols_count);
+  nonogram_board_set(solution, 2, 0, NONOGRAM_FILLED);
+  assert(!nonogram_hints_check(hints, solution));
+  assert(nonogram_hints_solve(hints, solution) == -1);
+  nonogram_board_destroy(solution);
+
+  int row0[] = {1, 1, 0};
+  int row1[] = {2, 0};
+  int row2[] = {0};
+  int row3[] = {2, 0};
+  int col0[] = {1, 0};
+  int col1[] = {1, 1, 0};
+  int col2[] = {2, 1, 0};
+  int *rows[] = {row0, row1, row2, row3};
+  int *cols[] = {col0, col1, col2};
+  NonoGramHints *copy = nonogram_hints_create_from_clues(
+    rows, cols, rows_count, cols_count
+  );
+  assert(copy);
+  for (int row = 0; row < rows_count; row++) {
+    for (int index = 0; index < cols_count; index++) {
+      assert(nonogram_hints_get_row_value(copy, row, index) ==
+             nonogram_hints_get_row_value(hints, row, index));
+    }
+  }
+  for (int col = 0; col < cols_count; col++) {
+    for (int index = 0; index < rows_count; index++) {
+      assert(nonogram_hints_get_col_value(copy, col, index) ==
+             nonogram_hints_get_col_value(hints, col, index));
+    }
+  }
+  nonogram_hints_destroy(copy);
+
+  // Clues that cannot fit are rejected before anything is solved
+  int huge[] = {0x7fffffff, 0x7fffffff, 3, 0};
+  rows[0] = huge;
+  copy = nonogram_hints_create_from_clues(rows, cols, rows_count, cols_count);
+  solution = nonogram_board_create(rows_count, cols_count);
+  assert(!nonogram_hints_check(copy, solution));
+  assert(nonogram_hints_solve(copy, solution) == -1);
+  nonogram_board_destroy(solution);
+  nonogram_hints_destroy(copy);
+
+  nonogram_hints_destroy(hints);
+  for (int row = 0; row < rows_count; row++) {
+    free(board[row]);
+  }
+  free(board);
+
+  // Parallel propagation reaches the same fixpoint
+  rows_count = 150;
+  cols_count = 120;
+  board = malloc(rows_count * sizeof(int *));
+  unsigned int seed = 1;
+  for (int row = 0; row < rows_count; row++) {
+    board[row] = malloc(cols_count * sizeof(int));
+    for (int col = 0; col < cols_count; col++) {
+      seed = seed * 1103515245 + 12345;
+      board[row][col] = (seed >> 16) % 100 < 65;
+    }
+  }
+  hints = nonogram_hints_create(board, rows_count, cols_count);
+  NonoGramBoard *sequential = nonogram_board_create(rows_count, cols_count);
+  NonoGramBoard *parallel = nonogram_board_create(rows_count, cols_count);
+  NonoGramPool *pool = nonogram_pool_create(4);
+  int unknown = nonogram_hints_solve(hints, sequential);
+  assert(unknown >= 0);
+  assert(nonogram_hints_solve_parallel(hints, parallel, pool) == unknown);
+  for (int row = 0; row < rows_count; row++) {
+    for (int col = 0; col < cols_count; col++) {
+      int value = nonogram_board_get(sequential, row, col);
+      assert(nonogram_board_get(parallel, row, col) == value);
+      assert(value == NONOGRAM_UNKNOWN || value == board[row][col]);
+    }
+  }
+  nonogram_pool_destroy(pool);
+  nonogram_board_destroy(sequential);
+  nonogram_board_destroy(parallel);
+  nonogram_hints_destroy(hints);
+  for (int row = 0; row < rows_count; row++) {
+    free(board[row]);
+  }
+  free(board);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,99 @@
+// Copyright © Christophe Demko <christophe.demko@univ-lr.fr>, 2024
+// Licensed under the BSD-3 License. See the LICENSE file for details.
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+
+#include "./nonogram.h"
+
+#define SIZE 10
+
+static unsigned long state = 2024;
+
+static int next_random(int max) {
+  state = state * 6364136223846793005UL + 1442695040888963407UL;
+  return (int)((state >> 33) % max);
+}
+
+/* Probe then search board, as nonogram-solve --probe does */
+static int solve(NonoGramHints *hints, NonoGramBoard *board) {
+  int unknown = nonogram_hints_solve(hints, board);
+  if (unknown > 0) {
+    unknown = nonogram_hints_probe(hints, board);
+  }
+  return unknown > 0 ? nonogram_hints_search(hints, board) : unknown;
+}
+
+int main(void) {
+  NonoGramMemo *memo = nonogram_memo_create(10);
+  assert(memo);
+  assert(nonogram_memo_get_size(memo) >= 10);
+  assert(nonogram_memo_use(memo) == NULL);
+  assert(nonogram_memo_use(NULL) == memo);
+
+  // Line solves give the same lines from the table, contradictions included
+  int clues[] = {3, 1};
+  int given[] = {-1, 1, -1, -1, -1, -1, 0};
+  int expected[7], line[7];
+  memcpy(expected, given, sizeof given);
+  int settled = nonogram_line_solve(clues, 2, expected, 7);
+  nonogram_memo_use(memo);
+  NonoGramStats stats;
+  memset(&stats, 0, sizeof stats);
+  nonogram_stats_collect(&stats);
+  for (int round = 0; round < 2; round++) {
+    memcpy(line, given, sizeof given);
+    assert(nonogram_line_solve(clues, 2, line, 7) == settled);
+    assert(!memcmp(line, expected, sizeof line));
+  }
+  assert(stats.memo_hits == 1);
+  int wrong[] = {1, 0, 1, -1, -1, -1, -1};
+  for (int round = 0; round < 2; round++) {
+    memcpy(line, wrong, sizeof wrong);
+    assert(nonogram_line_solve(clues, 2, line, 7) == -1);
+  }
+  assert(stats.memo_hits == 2);
+  nonogram_memo_clear(memo);
+  memcpy(line, given, sizeof given);
+  assert(nonogram_line_solve(clues, 2, line, 7) == settled);
+  assert(stats.memo_hits == 2);
+
+  // Puzzles solve alike with a table too small to keep every line
+  for (int puzzle = 0; puzzle < 50; puzzle++) {
+    NonoGramBoard *image = nonogram_board_create(SIZE, SIZE);
+    for (int row = 0; row < SIZE; row++) {
+      for (int col = 0; col < SIZE; col++) {
+        nonogram_board_set(image, row, col, next_random(2));
+      }
+    }
+    NonoGramHints *hints = nonogram_hints_create_from_board(image);
+    NonoGramBoard *boards[2];
+    int results[2];
+    for (int round = 0; round < 2; round++) {
+      nonogram_memo_use(round ? memo : NULL);
+      boards[round] = nonogram_board_create(SIZE, SIZE);
+      results[round] = solve(hints, boards[round]);
+    }
+    assert(results[0] == results[1]);
+    for (int row = 0; row < SIZE; row++) {
+      for (int col = 0; col < SIZE; col++) {
+        assert(nonogram_board_get(boards[0], row, col) ==
+               nonogram_board_get(boards[1], row, col));
+      }
+    }
+    nonogram_board_destroy(boards[0]);
+    nonogram_board_destroy(boards[1]);
+    nonogram_hints_destroy(hints);
+    nonogram_board_destroy(image);
+  }
+  assert(stats.memo_hits > 2);
+  nonogram_stats_collect(NULL);
+
+  nonogram_memo_destroy(memo);
+  assert(nonogram_memo_use(NULL) == NULL);
+  return EXIT_SUCCESS;
+}
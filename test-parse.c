@@ -0,0 +1,113 @@
+// Copyright © Christophe Demko <christophe.demko@univ-lr.fr>, 2024
+// Licensed under the BSD-3 License. See the LICENSE file for details.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+
+#include "./nonogram.h"
+#include "./nonogram.inc"
+
+static void check_same(NonoGramHints *hints, NonoGramHints *expected) {
+  assert(hints);
+  assert(hints->rows_count == expected->rows_count);
+  assert(hints->cols_count == expected->cols_count);
+  int lines_count = hints->rows_count + hints->cols_count;
+  assert(memcmp(hints->offsets, expected->offsets,
+                (lines_count + 1) * sizeof(int)) == 0);
+  assert(memcmp(hints->clues, expected->clues,
+                hints->offsets[lines_count] * sizeof(int)) == 0);
+}
+
+int main(void) {
+  int rows_count = 5;
+  int cols_count = 5;
+  int **board = malloc(rows_count * sizeof(int *));
+  for (int row = 0; row < rows_count; row++) {
+    board[row] = calloc(cols_count, sizeof(int));
+  }
+  board[0][0] = 1;
+  board[0][1] = 1;
+  board[0][3] = 1;
+  board[1][0] = 1;
+  board[1][4] = 1;
+  board[3][0] = 1;
+  board[3][4] = 1;
+  board[4][0] = 1;
+  board[4][1] = 1;
+  board[4][3] = 1;
+  board[4][4] = 1;
+  NonoGramHints *expected = nonogram_hints_create(board, rows_count, cols_count);
+
+  NonoGramHints *hints = nonogram_hints_parse(
+    nonogram_hints_to_string(expected)
+  );
+  check_same(hints, expected);
+  nonogram_hints_destroy(hints);
+
+  // Whitespace, key order, unknown keys and zero clues
+  hints = nonogram_hints_parse(
+    " {\n  \"cols\" : [[2, 2], [1,1], [0], [1, 1], [1, 2]],\n"
+    "  \"title\": \"Smile \\\"x\\\"\", \"meta\": {\"size\": [5, 5.0], "
+    "\"ok\": true},\n"
+    "  \"rows\": [ [2,1] ,[1,1],[],[1,1],[2,2] ]\n}\n"
+  );
+  check_same(hints, expected);
+  nonogram_hints_destroy(hints);
+
+  // Malformed inputs
+  assert(!nonogram_hints_parse(""));
+  assert(!nonogram_hints_parse("{}"));
+  assert(!nonogram_hints_parse("{\"rows\":[[1]]}"));
+  assert(!nonogram_hints_parse("{\"rows\":[[1]],\"cols\":[[1]]"));
+  assert(!nonogram_hints_parse("{\"rows\":[[1.5]],\"cols\":[[1]]}"));
+  assert(!nonogram_hints_parse("{\"rows\":[[-1]],\"cols\":[[1]]}"));
+  assert(!nonogram_hints_parse("{\"rows\":[[1],],\"cols\":[[1]]}"));
+  assert(!nonogram_hints_parse("{\"rows\":[],\"cols\":[]}"));
+  // 0 is only an empty line on its own, and clues must fit in their line
+  assert(!nonogram_hints_parse("{\"rows\":[[1,0,1]],\"cols\":[[1],[],[1]]}"));
+  assert(!nonogram_hints_parse("{\"rows\":[[0,0]],\"cols\":[[],[]]}"));
+  assert(!nonogram_hints_parse("{\"rows\":[[2,1]],\"cols\":[[1],[1],[1]]}"));
+  assert(!nonogram_hints_parse(
+    "{\"rows\":[[2147483647,2147483647,3]],\"cols\":[[1],[1],[1]]}"
+  ));
+  nonogram_hints_destroy(expected);
+
+  // A document larger than the read buffer
+  for (int row = 0; row < rows_count; row++) {
+    free(board[row]);
+  }
+  free(board);
+  rows_count = 120;
+  cols_count = 150;
+  board = malloc(rows_count * sizeof(int *));
+  for (int row = 0; row < rows_count; row++) {
+    board[row] = malloc(cols_count * sizeof(int));
+    for (int col = 0; col < cols_count; col++) {
+      board[row][col] = (row * 7 + col * 13) % 5 < 2;
+    }
+  }
+  expected = nonogram_hints_create(board, rows_count, cols_count);
+  const char *string = nonogram_hints_to_string(expected);
+  assert(strlen(string) > BUFSIZ);
+  FILE *file = tmpfile();
+  assert(file);
+  fputs(string, file);
+  rewind(file);
+  hints = nonogram_hints_read(file);
+  fclose(file);
+  check_same(hints, expected);
+  nonogram_hints_destroy(hints);
+  nonogram_hints_to_string(NULL);
+  nonogram_hints_destroy(expected);
+  for (int row = 0; row < rows_count; row++) {
+    free(board[row]);
+  }
+  free(board);
+
+  return EXIT_SUCCESS;
+}
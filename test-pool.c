@@ -0,0 +1,54 @@
+// Copyright © Christophe Demko <christophe.demko@univ-lr.fr>, 2024
+// Licensed under the BSD-3 License. See the LICENSE file for details.
+#include <stdlib.h>
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+
+#include "./nonogram.h"
+#include "./nonogram.inc"
+
+typedef struct {
+  int *runs;       // Number of times each task ran
+  int *workers;    // Worker that ran each task
+  int workers_count;
+} Job;
+
+static void task(void *data, int index, int worker) {
+  Job *job = data;
+  // Uneven task lengths so that workers have to steal
+  volatile unsigned long sink = 0;
+  for (unsigned long i = 0; i < (index % 7 == 0 ? 200000UL : 10UL); i++) {
+    sink += i;
+  }
+  assert(worker >= 0 && worker < job->workers_count);
+  job->runs[index]++;
+  job->workers[index] = worker;
+}
+
+int main(void) {
+  assert(nonogram_pool_create(0) == NULL);
+
+  for (int workers_count = 1; workers_count <= 4; workers_count++) {
+    NonoGramPool *pool = nonogram_pool_create(workers_count);
+    assert(pool);
+    assert(nonogram_pool_get_workers_count(pool) == workers_count);
+    for (int tasks_count = 0; tasks_count <= 1000; tasks_count += 250) {
+      Job job;
+      job.runs = calloc(tasks_count + 1, sizeof(int));
+      job.workers = calloc(tasks_count + 1, sizeof(int));
+      job.workers_count = workers_count;
+      nonogram_pool_run(pool, tasks_count, task, &job);
+      for (int index = 0; index < tasks_count; index++) {
+        assert(job.runs[index] == 1);
+      }
+      free(job.runs);
+      free(job.workers);
+    }
+    nonogram_pool_destroy(pool);
+  }
+
+  return EXIT_SUCCESS;
+}
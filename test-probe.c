@@ -0,0 +1,64 @@
+// Copyright © Christophe Demko <christophe.demko@univ-lr.fr>, 2024
+// Licensed under the BSD-3 License. See the LICENSE file for details.
+#include <stdlib.h>
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+
+#include "./nonogram.h"
+#include "./nonogram.inc"
+
+int main(void) {
+  {
+    // Random boards: probing settles at least what line logic settles, only
+    // with values of some solution, and never turns a puzzle unsolvable
+    srand(2024);
+    int improved = 0;
+    for (int round = 0; round < 200; round++) {
+      int rows_count = 4 + rand() % 9;
+      int cols_count = 4 + rand() % 9;
+      NonoGramBoard *source = nonogram_board_create(rows_count, cols_count);
+      for (int row = 0; row < rows_count; row++) {
+        for (int col = 0; col < cols_count; col++) {
+          nonogram_board_set(source, row, col, rand() % 2);
+        }
+      }
+      NonoGramHints *hints = nonogram_hints_create_from_board(source);
+      NonoGramBoard *solved = nonogram_board_create(rows_count, cols_count);
+      NonoGramBoard *probed = nonogram_board_create(rows_count, cols_count);
+      int unknown = nonogram_hints_solve(hints, solved);
+      int probed_unknown = nonogram_hints_probe(hints, probed);
+      assert(probed_unknown >= 0 && probed_unknown <= unknown);
+      improved += probed_unknown < unknown;
+      for (int row = 0; row < rows_count; row++) {
+        for (int col = 0; col < cols_count; col++) {
+          int value = nonogram_board_get(solved, row, col);
+          assert(value == NONOGRAM_UNKNOWN ||
+                 value == nonogram_board_get(probed, row, col));
+        }
+      }
+      assert(nonogram_hints_search(hints, probed) == 1);
+      assert(nonogram_hints_check(hints, probed));
+      nonogram_board_destroy(probed);
+      nonogram_board_destroy(solved);
+      nonogram_board_destroy(source);
+      nonogram_hints_destroy(hints);
+    }
+    assert(improved > 0);
+  }
+  {
+    // Every line is satisfiable alone, but not all together
+    int row_clues[][2] = {{1, 0}, {1, 0}, {0}};
+    int col_clues[][2] = {{1, 0}, {1, 0}, {1, 0}};
+    int *rows[] = {row_clues[0], row_clues[1], row_clues[2]};
+    int *cols[] = {col_clues[0], col_clues[1], col_clues[2]};
+    NonoGramHints *hints = nonogram_hints_create_from_clues(rows, cols, 3, 3);
+    NonoGramBoard *board = nonogram_board_create(3, 3);
+    assert(nonogram_hints_probe(hints, board) == -1);
+    nonogram_board_destroy(board);
+    nonogram_hints_destroy(hints);
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,169 @@
+// Copyright © Christophe Demko <christophe.demko@univ-lr.fr>, 2024
+// Licensed under the BSD-3 License. See the LICENSE file for details.
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+
+#include "./nonogram.h"
+#include "./nonogram.inc"
+
+static NonoGramHints *hints_from_clues(
+  int (*rows)[4],
+  int (*cols)[4],
+  int rows_count,
+  int cols_count
+) {
+  int *row_clues[16];
+  int *col_clues[16];
+  for (int row = 0; row < rows_count; row++) {
+    row_clues[row] = rows[row];
+  }
+  for (int col = 0; col < cols_count; col++) {
+    col_clues[col] = cols[col];
+  }
+  return nonogram_hints_create_from_clues(
+    row_clues, col_clues, rows_count, cols_count
+  );
+}
+
+/* The clues of board must be the clues of hints */
+static void check_solution(NonoGramHints *hints, NonoGramBoard *board) {
+  assert(nonogram_board_get_unknown_count(board) == 0);
+  NonoGramHints *solved = nonogram_hints_create_from_board(board);
+  int lines_count = hints->rows_count + hints->cols_count;
+  for (int line = 0; line <= lines_count; line++) {
+    assert(solved->offsets[line] == hints->offsets[line]);
+  }
+  for (int clue = 0; clue < hints->offsets[lines_count]; clue++) {
+    assert(solved->clues[clue] == hints->clues[clue]);
+  }
+  nonogram_hints_destroy(solved);
+}
+
+int main(void) {
+  {
+    // Two solutions: line logic settles nothing, search picks one
+    int rows[][4] = {{1, 0}, {1, 0}};
+    int cols[][4] = {{1, 0}, {1, 0}};
+    NonoGramHints *hints = hints_from_clues(rows, cols, 2, 2);
+    NonoGramBoard *board = nonogram_board_create(2, 2);
+    assert(nonogram_hints_solve(hints, board) == 4);
+    assert(nonogram_hints_search(hints, board) == 1);
+    check_solution(hints, board);
+    nonogram_board_destroy(board);
+    nonogram_hints_destroy(hints);
+  }
+  {
+    // Every line is satisfiable alone, but not all together
+    int rows[][4] = {{1, 0}, {1, 0}, {0}};
+    int cols[][4] = {{1, 0}, {1, 0}, {1, 0}};
+    NonoGramHints *hints = hints_from_clues(rows, cols, 3, 3);
+    NonoGramBoard *board = nonogram_board_create(3, 3);
+    nonogram_board_set(board, 0, 0, NONOGRAM_FILLED);
+    assert(nonogram_hints_search(hints, board) == 0);
+    // The board is left as given
+    assert(nonogram_board_get_unknown_count(board) == 8);
+    assert(nonogram_board_get(board, 0, 0) == NONOGRAM_FILLED);
+    nonogram_board_destroy(board);
+    nonogram_hints_destroy(hints);
+  }
+  {
+    // Random boards: the hints of the board found are the hints searched
+    srand(2024);
+    for (int round = 0; round < 50; round++) {
+      int rows_count = 4 + rand() % 17;
+      int cols_count = 4 + rand() % 17;
+      NonoGramBoard *source = nonogram_board_create(rows_count, cols_count);
+      for (int row = 0; row < rows_count; row++) {
+        for (int col = 0; col < cols_count; col++) {
+          nonogram_board_set(source, row, col, rand() % 2);
+        }
+      }
+      NonoGramHints *hints = nonogram_hints_create_from_board(source);
+      NonoGramBoard *board = nonogram_board_create(rows_count, cols_count);
+      assert(nonogram_hints_search(hints, board) == 1);
+      check_solution(hints, board);
+      nonogram_board_destroy(board);
+      nonogram_board_destroy(source);
+      nonogram_hints_destroy(hints);
+    }
+  }
+  {
+    // Counting stops at the second solution, with a pair of witnesses
+    int rows[][4] = {{1, 0}, {1, 0}, {0}};
+    int cols[][4] = {{1, 0}, {1, 0}, {0}};
+    NonoGramHints *hints = hints_from_clues(rows, cols, 3, 3);
+    NonoGramBoard *board = nonogram_board_create(3, 3);
+    NonoGramBoard *witnesses[2];
+    assert(nonogram_hints_count_solutions(hints, board, witnesses) == 2);
+    assert(nonogram_board_get_unknown_count(board) == 9);
+    check_solution(hints, witnesses[0]);
+    check_solution(hints, witnesses[1]);
+    assert(nonogram_board_get(witnesses[0], 0, 0) !=
+           nonogram_board_get(witnesses[1], 0, 0));
+    nonogram_board_destroy(witnesses[0]);
+    nonogram_board_destroy(witnesses[1]);
+
+    // Known cells rule the other solution out
+    nonogram_board_set(board, 0, 0, NONOGRAM_FILLED);
+    assert(nonogram_hints_count_solutions(hints, board, witnesses) == 1);
+    assert(nonogram_board_get_unknown_count(board) == 8);
+    check_solution(hints, witnesses[0]);
+    assert(nonogram_board_get(witnesses[0], 1, 1) == NONOGRAM_FILLED);
+    assert(witnesses[1] == NULL);
+    nonogram_board_destroy(witnesses[0]);
+
+    nonogram_board_set(board, 1, 0, NONOGRAM_FILLED);
+    assert(nonogram_hints_count_solutions(hints, board, witnesses) == 0);
+    assert(witnesses[0] == NULL && witnesses[1] == NULL);
+    assert(nonogram_hints_count_solutions(hints, board, NULL) == 0);
+    nonogram_board_destroy(board);
+    nonogram_hints_destroy(hints);
+  }
+  {
+    // Puzzles solved by line logic alone have one solution
+    int rows[][4] = {{3, 0}, {1, 1, 0}, {3, 0}};
+    int cols[][4] = {{3, 0}, {1, 1, 0}, {3, 0}};
+    NonoGramHints *hints = hints_from_clues(rows, cols, 3, 3);
+    NonoGramBoard *board = nonogram_board_create(3, 3);
+    assert(nonogram_hints_count_solutions(hints, board, NULL) == 1);
+    nonogram_board_destroy(board);
+    nonogram_hints_destroy(hints);
+  }
+  {
+    // Statistics are gathered while a structure is being collected into
+    int rows[][4] = {{1, 0}, {1, 0}};
+    int cols[][4] = {{1, 0}, {1, 0}};
+    NonoGramHints *hints = hints_from_clues(rows, cols, 2, 2);
+    NonoGramBoard *board = nonogram_board_create(2, 2);
+    NonoGramStats stats;
+    memset(&stats, 0, sizeof stats);
+    assert(nonogram_stats_collect(&stats) == NULL);
+    assert(nonogram_hints_count_solutions(hints, board, NULL) == 2);
+    assert(nonogram_stats_collect(NULL) == &stats);
+    assert(stats.line_solves > 0);
+    assert(stats.search_nodes > 0);
+    assert(stats.backtracks > 0);
+    assert(stats.max_depth > 0);
+    NonoGramStats collected = stats;
+    assert(nonogram_hints_search(hints, board) == 1);
+    assert(memcmp(&stats, &collected, sizeof stats) == 0);
+    nonogram_board_destroy(board);
+    nonogram_hints_destroy(hints);
+  }
+  {
+    // Dimensions must match
+    int rows[][4] = {{1, 0}, {1, 0}};
+    int cols[][4] = {{1, 0}, {1, 0}};
+    NonoGramHints *hints = hints_from_clues(rows, cols, 2, 2);
+    NonoGramBoard *board = nonogram_board_create(2, 3);
+    assert(nonogram_hints_search(hints, board) == -1);
+    nonogram_board_destroy(board);
+    nonogram_hints_destroy(hints);
+  }
+  return EXIT_SUCCESS;
+}
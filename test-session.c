@@ -0,0 +1,141 @@
+// Copyright © Christophe Demko <christophe.demko@univ-lr.fr>, 2024
+// Licensed under the BSD-3 License. See the LICENSE file for details.
+#include <stdlib.h>
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+
+#include "./nonogram.h"
+#include "./nonogram.inc"
+
+#define SIZE 12
+
+static unsigned long state = 12345;
+
+static int next_random(int max) {
+  state = state * 6364136223846793005UL + 1442695040888963407UL;
+  return (int)((state >> 33) % max);
+}
+
+/* Zero-terminated runs of filled cells of a line of the image */
+static void line_clues(int image[SIZE][SIZE], int line, int *clues) {
+  int count = 0;
+  int run = 0;
+  for (int index = 0; index <= SIZE; index++) {
+    int cell = index == SIZE ? 0
+      : line < SIZE ? image[line][index] : image[index][line - SIZE];
+    if (cell) {
+      run++;
+    } else if (run) {
+      clues[count++] = run;
+      run = 0;
+    }
+  }
+  clues[count] = 0;
+}
+
+/* The session must agree with line logic run from scratch */
+static void check(NonoGramSession *session, int fixed[SIZE][SIZE]) {
+  NonoGramHints *hints = nonogram_session_get_hints(session);
+  NonoGramBoard *board = nonogram_board_create(SIZE, SIZE);
+  for (int row = 0; row < SIZE; row++) {
+    for (int col = 0; col < SIZE; col++) {
+      nonogram_board_set(board, row, col, fixed[row][col]);
+    }
+  }
+  int expected = nonogram_hints_solve(hints, board);
+  assert(nonogram_session_get_status(session) == expected);
+  if (expected >= 0) {
+    NonoGramBoard *solved = nonogram_session_get_board(session);
+    for (int row = 0; row < SIZE; row++) {
+      for (int col = 0; col < SIZE; col++) {
+        assert(nonogram_board_get(solved, row, col) ==
+               nonogram_board_get(board, row, col));
+      }
+    }
+  }
+  nonogram_board_destroy(board);
+}
+
+int main(void) {
+  int image[SIZE][SIZE];
+  int fixed[SIZE][SIZE];
+  int clues[SIZE + 1];
+  NonoGramBoard *board = nonogram_board_create(SIZE, SIZE);
+  for (int row = 0; row < SIZE; row++) {
+    for (int col = 0; col < SIZE; col++) {
+      image[row][col] = next_random(2);
+      fixed[row][col] = NONOGRAM_UNKNOWN;
+      nonogram_board_set(board, row, col, image[row][col]);
+    }
+  }
+  NonoGramHints *hints = nonogram_hints_create_from_board(board);
+  nonogram_board_destroy(board);
+  NonoGramSession *session = nonogram_session_create(hints);
+  nonogram_hints_destroy(hints);
+  assert(session);
+  check(session, fixed);
+
+  // Invalid arguments leave the session as it was
+  assert(nonogram_session_set_cell(session, SIZE, 0, NONOGRAM_FILLED) == -1);
+  assert(nonogram_session_set_cell(session, 0, 0, 2) == -1);
+  assert(nonogram_session_set_row_clues(session, -1, clues) == -1);
+  assert(nonogram_session_set_col_clues(session, SIZE, clues) == -1);
+
+  for (int edit = 0; edit < 2000; edit++) {
+    int row = next_random(SIZE);
+    int col = next_random(SIZE);
+    switch (next_random(3)) {
+      case 0:
+        // Release a cell
+        fixed[row][col] = NONOGRAM_UNKNOWN;
+        assert(!nonogram_session_set_cell(session, row, col, fixed[row][col]));
+        check(session, fixed);
+        break;
+      case 1:
+        // Fix a cell, now and then against the image first
+        if (!next_random(8)) {
+          fixed[row][col] = !image[row][col];
+          assert(!nonogram_session_set_cell(session, row, col, fixed[row][col]));
+          check(session, fixed);
+        }
+        fixed[row][col] = image[row][col];
+        assert(!nonogram_session_set_cell(session, row, col, fixed[row][col]));
+        check(session, fixed);
+        break;
+      default:
+        // Flip a cell of the image, then update the cell if it is fixed, its
+        // row and its column, checking in between now and then
+        image[row][col] = !image[row][col];
+        if (fixed[row][col] != NONOGRAM_UNKNOWN) {
+          fixed[row][col] = image[row][col];
+          assert(!nonogram_session_set_cell(session, row, col, fixed[row][col]));
+        }
+        line_clues(image, row, clues);
+        assert(!nonogram_session_set_row_clues(session, row, clues));
+        if (!next_random(4)) {
+          check(session, fixed);
+        }
+        line_clues(image, SIZE + col, clues);
+        assert(!nonogram_session_set_col_clues(session, col, clues));
+        check(session, fixed);
+        break;
+    }
+  }
+
+  // The hints follow the image
+  hints = nonogram_session_get_hints(session);
+  for (int line = 0; line < 2 * SIZE; line++) {
+    line_clues(image, line, clues);
+    for (int index = 0; clues[index]; index++) {
+      assert(line < SIZE
+        ? nonogram_hints_get_row_value(hints, line, index) == clues[index]
+        : nonogram_hints_get_col_value(hints, line - SIZE, index) ==
+          clues[index]);
+    }
+  }
+  nonogram_session_destroy(session);
+  return EXIT_SUCCESS;
+}
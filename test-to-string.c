@@ -47,6 +47,19 @@ int main(void) {
                 "{\"rows\":[[2,1],[1,1],[],[1,1],[2,2]],"
                 "\"cols\":[[2,2],[1,1],[],[1,1],[1,2]]}") == 0);
   nonogram_hints_to_string(NULL);
+
+  // Caller buffers: a size of 0 queries the length, short buffers truncate
+  const char *expected = "{\"rows\":[[2,1],[1,1],[],[1,1],[2,2]],"
+                         "\"cols\":[[2,2],[1,1],[],[1,1],[1,2]]}";
+  size_t length = nonogram_hints_format(hints, NULL, 0);
+  assert(length == strlen(expected));
+  char buffer[128];
+  memset(buffer, '#', sizeof buffer);
+  assert(nonogram_hints_format(hints, buffer, length + 1) == length);
+  assert(strcmp(buffer, expected) == 0);
+  assert(buffer[length + 1] == '#');
+  assert(nonogram_hints_format(hints, buffer, 10) == length);
+  assert(strcmp(buffer, "{\"rows\":[") == 0);
   nonogram_hints_destroy(hints);
   for (int row = 0; row < rows_count; row++) {
     free(board[row]);